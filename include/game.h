@@ -15,11 +15,46 @@
 #include <errno.h>
 #include <time.h>
 #include <sys/wait.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+// Arena dimensions can be overridden at build time (see Makefile)
+#ifndef BOARD_SIZE
 #define BOARD_SIZE 10
+#endif
 #define MAX_TEAMS 4
+#ifndef MAX_PLAYERS_PER_TEAM
 #define MAX_PLAYERS_PER_TEAM 10
+#endif
+#define MAX_PLAYERS (MAX_TEAMS * MAX_PLAYERS_PER_TEAM)
+#define MIN_GAME_SECONDS 10
+#define ORPHAN_GRACE_SECONDS 30
+#define SERVICE_GRACE_SECONDS 2
+// A service (arbiter, referee) that misses its heartbeat past this deadline
+// is treated as gone
+#define SERVICE_DEADLINE(tick_usec) ((int)time(NULL) + SERVICE_GRACE_SECONDS + (tick_usec) / 1000000)
 #define EMPTY_CELL 0
+#define WALL_CELL (-1)
+
+// The board is stored with a one-cell WALL_CELL border, so any neighbour of
+// an on-board cell can be read without a bounds check. Cells are addressed
+// with BOARD_CELL, or linearly from CELL_INDEX plus a neighbour offset.
+#define BOARD_STRIDE (BOARD_SIZE + 2)
+#define BOARD_CELL(state, x, y) ((state)->board[(x) + 1][(y) + 1])
+#define CELL_INDEX(x, y) (((x) + 1) * BOARD_STRIDE + (y) + 1)
+
+// Stamped into the arena by its creator, so a binary built with other
+// arena dimensions refuses to read it
+#define ARENA_MAGIC 0x4c454d49
 
 #define IPC_KEY_BASE 0x12345
 #define SHM_KEY (IPC_KEY_BASE + 1)
@@ -27,23 +62,63 @@
 #define SEM_KEY (IPC_KEY_BASE + 3)
 
 #define SEM_BOARD 0
-#define SEM_COUNT 1
+#define SEM_TICK_EVEN 1
+#define SEM_TICK_ODD 2
+#define SEM_COUNT 3
 
 typedef struct {
 	int x;
 	int y;
 } position_t;
 
+// Move a player asked for, applied later by whoever commits the batch
+typedef struct {
+	position_t target;
+	int pending;
+} move_intent_t;
+
+// Shared tick barrier for lockstep games
+typedef struct {
+	int enabled;
+	int participants;
+	int arrived;
+	unsigned int generation;
+	unsigned int seed;
+	int tick_usec;
+	unsigned int min_ticks;
+	int waiting[MAX_PLAYERS];
+	int joined[MAX_PLAYERS];        // counted in participants until lockstep_leave
+	int released_on[MAX_PLAYERS];   // tick semaphore holding our wake-up, 0 once taken
+} lockstep_t;
+
 typedef struct {
-	int board[BOARD_SIZE][BOARD_SIZE];
+	unsigned int magic;
+	unsigned int state_size;
+	int board_size;
+	int max_players_per_team;
+	int board[BOARD_STRIDE][BOARD_STRIDE];
 	int player_count;
 	int teams_alive;
 	int game_over;
-	position_t players[MAX_TEAMS * MAX_PLAYERS_PER_TEAM];
-	int player_teams[MAX_TEAMS * MAX_PLAYERS_PER_TEAM];
+	position_t players[MAX_PLAYERS];
+	int player_teams[MAX_PLAYERS];
 	int team_counts[MAX_TEAMS + 1];
 	int total_kills;
+	int total_joins;
+	long total_moves;
 	int game_start_time;
+	move_intent_t intents[MAX_PLAYERS];
+	int eliminated[MAX_PLAYERS];
+	int orphaned[MAX_PLAYERS];
+	int orphans_expire_at;      // restored slots nobody adopted leave then
+	int slot_owners[MAX_PLAYERS];   // pid that placed each slot
+	lockstep_t lockstep;
+	unsigned int epoch;
+	int arbiter_pid;
+	int arbiter_alive_until;    // arbiter heartbeat, see SERVICE_DEADLINE
+	int referee_pid;
+	int referee_alive_until;    // referee heartbeat, see SERVICE_DEADLINE
+	unsigned int notify_seq;
 } game_state_t;
 
 // Message structure for IPC communication
@@ -63,9 +138,39 @@ typedef struct {
 	int shm_id;
 	int msg_id;
 	int sem_id;
+	int tick_usec;
+	int ai_budget_usec;
+	const char *restore_path;
 	game_state_t *game_state;
 } player_t;
 
+// Chooses the next move for a player, {-1, -1} to stay put
+typedef position_t (*move_planner_t)(player_t *player, void *context);
+
+// Board stream frames sent by the exporter. Every frame starts with a
+// header; a keyframe is followed by BOARD_SIZE * BOARD_SIZE cell bytes in
+// row order, a delta by `count` cell_change_t records.
+#define FRAME_KEY 1
+#define FRAME_DELTA 2
+
+typedef struct {
+	uint8_t type;
+	uint8_t game_over;
+	uint16_t board_size;
+	uint32_t seq;
+	uint32_t count;
+	int32_t player_count;
+	int32_t teams_alive;
+	int32_t total_kills;
+	int32_t team_counts[MAX_TEAMS + 1];
+} frame_header_t;
+
+typedef struct __attribute__((packed)) {
+	uint16_t x;
+	uint16_t y;
+	uint8_t team;
+} cell_change_t;
+
 // Action types for messages
 enum actions {
 	ACTION_JOIN = 1,
@@ -80,15 +185,71 @@ enum actions {
 
 void init_ipc(player_t *player);
 void cleanup_ipc(player_t *player);
+void destroy_ipc(player_t *player);
+int attach_ipc(player_t *player);
+int arena_exists(void);
+void arena_notify(game_state_t *game_state);
+void arena_wait(game_state_t *game_state, unsigned int seq, int timeout_usec);
 void init_board(game_state_t *game_state);
 void display_board(game_state_t *game_state, int sem_id);
 int place_player(player_t *player);
 int move_player(player_t *player, int new_x, int new_y);
 int check_kill_condition(player_t *player);
+int count_adjacent_enemies(game_state_t *game_state, int team, int x, int y);
 void remove_player(player_t *player);
+void clear_player_slot(game_state_t *game_state, int slot, position_t pos, int team);
+int apply_move_intents(game_state_t *game_state);
+int resolve_kills(game_state_t *game_state);
+int expire_orphans(game_state_t *game_state);
+int check_board_invariants(const game_state_t *game_state, char *report, size_t size);
+position_t plan_move(player_t *player, unsigned int *seed);
+position_t plan_shared_move(player_t *player, position_t *target, int *target_team,
+							unsigned int *seed);
 int is_game_over(game_state_t *game_state);
 void sem_lock(int sem_id, int sem_num);
 void sem_unlock(int sem_id, int sem_num);
-void player_game_loop(player_t *player, int display_mode);
+int player_game_loop(player_t *player, int display_mode);
+int run_player_loop(player_t *player, int display_mode, move_planner_t planner, void *context);
+void request_player_stop(void);
+int player_stop_requested(void);
+
+// Lockstep tick mode
+void lockstep_enable(game_state_t *game_state, unsigned int seed, int tick_usec);
+void lockstep_join(player_t *player);
+void lockstep_leave(player_t *player);
+void lockstep_game_loop(player_t *player, int display_mode);
+
+// Central arbiter mode
+void arbiter_loop(player_t *arena);
+void arbiter_player_loop(player_t *player);
+void arbiter_leave(player_t *player);
+int arbiter_running(game_state_t *game_state);
+
+// Referee process
+void referee_loop(player_t *arena);
+int referee_running(game_state_t *game_state);
+
+// Lookahead planner
+int lookahead_move(player_t *player, position_t *move);
+int lookahead_move_from(player_t *player, const game_state_t *view,
+						pthread_mutex_t *view_lock, position_t *move);
+
+// Checkpoint and restore
+int checkpoint_arena(player_t *arena, const char *path);
+int restore_arena(player_t *player, const char *path);
+
+// Board delta exporter
+int export_board(player_t *arena, const char *socket_path, int interval_ms);
+
+// Thread-per-team hosting
+int team_host_run(player_t *arena, int count, int display_mode);
+
+// Swarm launcher helpers
+pid_t spawn_player(const player_t *player, int cpu);
+pid_t spawn_team(const player_t *arena, int team, int count, int cpu);
+pid_t spawn_service(const player_t *arena, void (*loop)(player_t *));
+pid_t spawn_program(char *const argv[], int cpu);
+void swarm_quiet_players(int quiet);
+int wait_for_players(player_t *arena, int target, pid_t *pids, int count, int timeout_ms);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "game.h"
+
+// In arbiter mode players never mutate the board. They post a move intent in
+// their own mailbox (intents[slot]) and a single arbiter process drains all
+// mailboxes in one pass per period, under one SEM_BOARD acquisition. The
+// board epoch works like a seqlock: it is odd while a batch is being applied,
+// so players can plan without the lock and retry if a batch slipped in.
+
+static volatile sig_atomic_t g_arbiter_stop = 0;
+
+static void arbiter_signal_handler(int sig) {
+	(void)sig;
+	g_arbiter_stop = 1;
+}
+
+void arbiter_loop(player_t *arena) {
+	game_state_t *game_state = arena->game_state;
+	long batches = 0;
+	long moves = 0;
+	long kills = 0;
+
+	signal(SIGINT, arbiter_signal_handler);
+	signal(SIGTERM, arbiter_signal_handler);
+	signal(SIGQUIT, arbiter_signal_handler);
+
+	while (!g_arbiter_stop && !game_state->game_over) {
+		usleep(arena->tick_usec);
+
+		sem_lock(arena->sem_id, SEM_BOARD);
+		__atomic_add_fetch(&game_state->epoch, 1, __ATOMIC_ACQ_REL);
+		game_state->arbiter_alive_until = SERVICE_DEADLINE(arena->tick_usec);
+
+		moves += apply_move_intents(game_state);
+		kills += resolve_kills(game_state);
+		if (is_game_over(game_state)) {
+			game_state->game_over = 1;
+		}
+
+		__atomic_add_fetch(&game_state->epoch, 1, __ATOMIC_RELEASE);
+		sem_unlock(arena->sem_id, SEM_BOARD);
+		batches++;
+	}
+
+	// Players stop posting intents nobody would drain
+	sem_lock(arena->sem_id, SEM_BOARD);
+	game_state->arbiter_pid = 0;
+	sem_unlock(arena->sem_id, SEM_BOARD);
+
+	printf("Arbiter: %ld batches, %ld moves applied, %ld kills\n", batches, moves, kills);
+}
+
+// A killed arbiter never clears arbiter_pid, so also require a recent
+// heartbeat. time() is a vDSO call, cheap enough for every tick.
+int arbiter_running(game_state_t *game_state) {
+	return game_state->arbiter_pid != 0 && time(NULL) <= game_state->arbiter_alive_until;
+}
+
+void arbiter_leave(player_t *player) {
+	game_state_t *game_state = player->game_state;
+
+	sem_lock(player->sem_id, SEM_BOARD);
+	if (!game_state->eliminated[player->player_id]) {
+		// The arbiter owns our position, the local copy may be stale
+		clear_player_slot(game_state, player->player_id,
+						  game_state->players[player->player_id], player->team);
+		game_state->eliminated[player->player_id] = 1;
+	}
+	sem_unlock(player->sem_id, SEM_BOARD);
+}
+
+// Plan from a consistent board epoch without taking SEM_BOARD
+static position_t plan_from_epoch(player_t *player, unsigned int *seed) {
+	game_state_t *game_state = player->game_state;
+	position_t next;
+	unsigned int epoch;
+
+	do {
+		epoch = __atomic_load_n(&game_state->epoch, __ATOMIC_ACQUIRE);
+		if (epoch & 1) {
+			sched_yield();
+			continue;
+		}
+		player->pos = game_state->players[player->player_id];
+		if (player->pos.x == -1) {
+			// Swept off the board by the batch we just raced with
+			next = player->pos;
+			continue;
+		}
+		next = plan_move(player, seed);
+	} while ((epoch & 1) || __atomic_load_n(&game_state->epoch, __ATOMIC_ACQUIRE) != epoch);
+
+	return next;
+}
+
+void arbiter_player_loop(player_t *player) {
+	game_state_t *game_state = player->game_state;
+	move_intent_t *intent = &game_state->intents[player->player_id];
+	unsigned int seed = time(NULL) + getpid();
+
+	while (!game_state->game_over && !player_stop_requested()) {
+		if (game_state->eliminated[player->player_id]) {
+			printf("💀 Player %d from team %d has been eliminated!\n",
+				   player->player_id, player->team);
+			return;
+		}
+		// Nobody applies our moves any more, leave the board
+		if (!arbiter_running(game_state)) {
+			printf("Arbiter gone, player %d from team %d leaving.\n",
+				   player->player_id, player->team);
+			return;
+		}
+
+		// Last intent not drained yet, wait for the next batch
+		if (!__atomic_load_n(&intent->pending, __ATOMIC_ACQUIRE)) {
+			position_t next = plan_from_epoch(player, &seed);
+			if (next.x != -1) {
+				intent->target = next;
+				__atomic_store_n(&intent->pending, 1, __ATOMIC_RELEASE);
+			}
+		}
+
+		usleep(player->tick_usec);
+	}
+
+	if (game_state->game_over) {
+		printf("Game over! Player %d from team %d exiting.\n",
+			   player->player_id, player->team);
+	}
+}
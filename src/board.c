@@ -3,10 +3,15 @@
 void init_board(game_state_t *game_state) {
 	int i, j;
 	
-	// Clear the board
+	// Clear the board inside its wall border
+	for (i = 0; i < BOARD_STRIDE; i++) {
+		for (j = 0; j < BOARD_STRIDE; j++) {
+			game_state->board[i][j] = WALL_CELL;
+		}
+	}
 	for (i = 0; i < BOARD_SIZE; i++) {
 		for (j = 0; j < BOARD_SIZE; j++) {
-			game_state->board[i][j] = EMPTY_CELL;
+			BOARD_CELL(game_state, i, j) = EMPTY_CELL;
 		}
 	}
 	
@@ -14,7 +19,15 @@ void init_board(game_state_t *game_state) {
 	game_state->teams_alive = 0;
 	game_state->game_over = 0;
 	game_state->total_kills = 0;
+	game_state->total_joins = 0;
+	game_state->total_moves = 0;
 	game_state->game_start_time = time(NULL);
+	game_state->epoch = 0;
+	game_state->arbiter_pid = 0;
+	game_state->arbiter_alive_until = 0;
+	game_state->referee_pid = 0;
+	game_state->referee_alive_until = 0;
+	game_state->notify_seq = 0;
 	
 	// Initialize team counts
 	for (i = 0; i <= MAX_TEAMS; i++) {
@@ -22,11 +35,24 @@ void init_board(game_state_t *game_state) {
 	}
 	
 	// Initialize player positions
-	for (i = 0; i < MAX_TEAMS * MAX_PLAYERS_PER_TEAM; i++) {
+	for (i = 0; i < MAX_PLAYERS; i++) {
 		game_state->players[i].x = -1;
 		game_state->players[i].y = -1;
 		game_state->player_teams[i] = 0;
+		game_state->intents[i].pending = 0;
+		game_state->eliminated[i] = 0;
+		game_state->orphaned[i] = 0;
+		game_state->slot_owners[i] = 0;
 	}
+	game_state->orphans_expire_at = 0;
+	
+	memset(&game_state->lockstep, 0, sizeof(lockstep_t));
+	
+	// Stamp the layout last, joiners wait for it before reading anything
+	game_state->state_size = sizeof(game_state_t);
+	game_state->board_size = BOARD_SIZE;
+	game_state->max_players_per_team = MAX_PLAYERS_PER_TEAM;
+	__atomic_store_n(&game_state->magic, ARENA_MAGIC, __ATOMIC_RELEASE);
 }
 
 void display_board(game_state_t *game_state, int sem_id) {
@@ -54,7 +80,7 @@ void display_board(game_state_t *game_state, int sem_id) {
 
 	for (i = 0; i < BOARD_SIZE; i++) {
 		for (j = 0; j < BOARD_SIZE; j++) {
-			board_copy[i][j] = game_state->board[i][j];
+			board_copy[i][j] = BOARD_CELL(game_state, i, j);
 		}
 	}
 
@@ -119,7 +145,7 @@ static int is_valid_position(int x, int y) {
 }
 
 static int is_position_empty(game_state_t *game_state, int x, int y) {
-	return (is_valid_position(x, y) && game_state->board[x][y] == EMPTY_CELL);
+	return (is_valid_position(x, y) && BOARD_CELL(game_state, x, y) == EMPTY_CELL);
 }
 
 static position_t find_empty_position(game_state_t *game_state) {
@@ -140,24 +166,86 @@ static position_t find_empty_position(game_state_t *game_state) {
 	return pos;
 }
 
+// Take over a slot of our team left behind by a restored checkpoint.
+// Caller must hold SEM_BOARD. Returns 0 if a slot was adopted.
+static int adopt_orphaned_slot(player_t *player) {
+	game_state_t *game_state = player->game_state;
+	int slot;
+	
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		if (game_state->orphaned[slot] && game_state->player_teams[slot] == player->team) {
+			game_state->orphaned[slot] = 0;
+			game_state->slot_owners[slot] = getpid();
+			game_state->total_joins++;
+			player->player_id = slot;
+			player->pos = game_state->players[slot];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+// A slot is free once its player has left the board. An eliminated slot
+// stays taken until its owner has exited, since the owner still has to find
+// its flag in eliminated[].
+static int is_slot_free(game_state_t *game_state, int slot) {
+	if (game_state->player_teams[slot] != 0) {
+		return 0;
+	}
+	if (!game_state->eliminated[slot]) {
+		return 1;
+	}
+	pid_t owner = game_state->slot_owners[slot];
+	return owner == 0 || (kill(owner, 0) == -1 && errno == ESRCH);
+}
+
+// Keep player->player_id if that slot is free, otherwise take the first free
+// one. Caller must hold SEM_BOARD. Returns -1 if every slot is taken.
+static int claim_slot(player_t *player) {
+	game_state_t *game_state = player->game_state;
+	int slot;
+	
+	if (player->player_id >= 0 && player->player_id < MAX_PLAYERS &&
+		is_slot_free(game_state, player->player_id)) {
+		return 0;
+	}
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		if (is_slot_free(game_state, slot)) {
+			player->player_id = slot;
+			return 0;
+		}
+	}
+	return -1;
+}
+
 int place_player(player_t *player) {
 	position_t pos;
 	int result = 0;
 	
 	sem_lock(player->sem_id, SEM_BOARD);
 	
+	expire_orphans(player->game_state);
+	if (adopt_orphaned_slot(player) == 0) {
+		sem_unlock(player->sem_id, SEM_BOARD);
+		return result;
+	}
+	
 	pos = find_empty_position(player->game_state);
-	if (pos.x == -1) {
+	if (pos.x == -1 || claim_slot(player) == -1) {
 		sem_unlock(player->sem_id, SEM_BOARD);
 		result = -1;
 		return result;
 	}
 	
 	player->pos = pos;
-	player->game_state->board[pos.x][pos.y] = player->team;
+	BOARD_CELL(player->game_state, pos.x, pos.y) = player->team;
 	player->game_state->players[player->player_id] = pos;
 	player->game_state->player_teams[player->player_id] = player->team;
+	player->game_state->intents[player->player_id].pending = 0;
+	player->game_state->eliminated[player->player_id] = 0;
+	player->game_state->slot_owners[player->player_id] = getpid();
 	player->game_state->player_count++;
+	player->game_state->total_joins++;
 	
 	if (player->team > 0 && player->team <= MAX_TEAMS) {
 		if (player->game_state->team_counts[player->team] == 0) {
@@ -177,47 +265,239 @@ int move_player(player_t *player, int new_x, int new_y) {
 	
 	sem_lock(player->sem_id, SEM_BOARD);
 	
-	if (!is_position_empty(player->game_state, new_x, new_y)) {
+	// A referee may have swept us off the board since our last check
+	if (player->game_state->eliminated[player->player_id] ||
+		!is_position_empty(player->game_state, new_x, new_y)) {
 		sem_unlock(player->sem_id, SEM_BOARD);
 		return -1;
 	}
 	
-	player->game_state->board[player->pos.x][player->pos.y] = EMPTY_CELL;
+	BOARD_CELL(player->game_state, player->pos.x, player->pos.y) = EMPTY_CELL;
 	player->pos.x = new_x;
 	player->pos.y = new_y;
-	player->game_state->board[new_x][new_y] = player->team;
+	BOARD_CELL(player->game_state, new_x, new_y) = player->team;
 	player->game_state->players[player->player_id] = player->pos;
+	player->game_state->total_moves++;
 	
 	sem_unlock(player->sem_id, SEM_BOARD);
 	return 0;
 }
 
+// Caller must hold SEM_BOARD
+void clear_player_slot(game_state_t *game_state, int slot, position_t pos, int team) {
+	if (is_valid_position(pos.x, pos.y)) {
+		BOARD_CELL(game_state, pos.x, pos.y) = EMPTY_CELL;
+	}
+	
+	game_state->players[slot].x = -1;
+	game_state->players[slot].y = -1;
+	game_state->player_teams[slot] = 0;
+	game_state->intents[slot].pending = 0;
+	game_state->orphaned[slot] = 0;
+	game_state->player_count--;
+	
+	if (team > 0 && team <= MAX_TEAMS) {
+		game_state->team_counts[team]--;
+		if (game_state->team_counts[team] == 0) {
+			game_state->teams_alive--;
+		}
+	}
+}
+
 void remove_player(player_t *player) {
 	sem_lock(player->sem_id, SEM_BOARD);
+	// Players eliminated by a batch commit are already off the board
+	if (!player->game_state->eliminated[player->player_id]) {
+		clear_player_slot(player->game_state, player->player_id, player->pos, player->team);
+	}
+	sem_unlock(player->sem_id, SEM_BOARD);
+}
+
+// Apply every pending move intent in slot order. When two players target the
+// same cell the lower slot gets there first and the other intent is dropped.
+// Caller must hold SEM_BOARD. Returns the number of moves applied.
+int apply_move_intents(game_state_t *game_state) {
+	int moved = 0;
+	int slot;
 	
-	if (is_valid_position(player->pos.x, player->pos.y)) {
-		player->game_state->board[player->pos.x][player->pos.y] = EMPTY_CELL;
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		// Arbiter players post intents without the lock: read the target
+		// only after seeing pending, and hand the mailbox back afterwards
+		move_intent_t *intent = &game_state->intents[slot];
+		if (!__atomic_load_n(&intent->pending, __ATOMIC_ACQUIRE)) {
+			continue;
+		}
+		position_t to = intent->target;
+		__atomic_store_n(&intent->pending, 0, __ATOMIC_RELEASE);
+		
+		// One step from an on-board cell never leaves the wall border, and a
+		// wall is never empty
+		int team = game_state->player_teams[slot];
+		position_t from = game_state->players[slot];
+		if (team == 0 || !is_valid_position(from.x, from.y) ||
+			abs(to.x - from.x) + abs(to.y - from.y) != 1 ||
+			BOARD_CELL(game_state, to.x, to.y) != EMPTY_CELL) {
+			continue;
+		}
+		
+		BOARD_CELL(game_state, from.x, from.y) = EMPTY_CELL;
+		BOARD_CELL(game_state, to.x, to.y) = team;
+		game_state->players[slot] = to;
+		moved++;
 	}
 	
-	player->game_state->players[player->player_id].x = -1;
-	player->game_state->players[player->player_id].y = -1;
-	player->game_state->player_teams[player->player_id] = 0;
-	player->game_state->player_count--;
+	game_state->total_moves += moved;
+	return moved;
+}
+
+// Take restored slots nobody rejoined off the board once their grace period
+// is over, so a partly resumed game can still end. Caller must hold
+// SEM_BOARD. Returns the number of slots removed.
+int expire_orphans(game_state_t *game_state) {
+	int expired = 0;
+	int slot;
 	
-	if (player->team > 0 && player->team <= MAX_TEAMS) {
-		player->game_state->team_counts[player->team]--;
-		if (player->game_state->team_counts[player->team] == 0) {
-			player->game_state->teams_alive--;
+	if (game_state->orphans_expire_at == 0 || time(NULL) < game_state->orphans_expire_at) {
+		return 0;
+	}
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		if (game_state->orphaned[slot]) {
+			clear_player_slot(game_state, slot, game_state->players[slot],
+							  game_state->player_teams[slot]);
+			expired++;
 		}
 	}
+	game_state->orphans_expire_at = 0;
+	return expired;
+}
+
+// Remove every surrounded player at once, so the order in which victims are
+// found does not change the outcome. Victims are flagged in eliminated[].
+// Caller must hold SEM_BOARD. Returns the number of kills.
+int resolve_kills(game_state_t *game_state) {
+	int victims[MAX_PLAYERS];
+	int victim_count = 0;
+	int slot, i;
 	
-	sem_unlock(player->sem_id, SEM_BOARD);
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		int team = game_state->player_teams[slot];
+		position_t pos = game_state->players[slot];
+		if (team != 0 && is_valid_position(pos.x, pos.y) &&
+			count_adjacent_enemies(game_state, team, pos.x, pos.y) >= 2) {
+			victims[victim_count++] = slot;
+		}
+	}
+	
+	for (i = 0; i < victim_count; i++) {
+		slot = victims[i];
+		clear_player_slot(game_state, slot, game_state->players[slot],
+						  game_state->player_teams[slot]);
+		game_state->eliminated[slot] = 1;
+		game_state->total_kills++;
+	}
+	
+	return victim_count;
+}
+
+// Cross-check the board against the slot table and the counters. Run it on a
+// copy taken under SEM_BOARD (or while holding it). Returns the number of
+// violations found and describes the first one in `report`.
+int check_board_invariants(const game_state_t *game_state, char *report, size_t size) {
+	int owner[BOARD_SIZE][BOARD_SIZE];
+	int cells[MAX_TEAMS + 1];
+	int violations = 0;
+	int i, j, slot, team;
+
+#define VIOLATION(...) do { \
+		if (violations++ == 0) { \
+			snprintf(report, size, __VA_ARGS__); \
+		} \
+	} while (0)
+
+	for (i = 0; i < BOARD_STRIDE; i++) {
+		for (j = 0; j < BOARD_STRIDE; j++) {
+			int border = (i == 0 || j == 0 || i == BOARD_STRIDE - 1 || j == BOARD_STRIDE - 1);
+			if (border && game_state->board[i][j] != WALL_CELL) {
+				VIOLATION("wall cell (%d,%d) holds %d", i - 1, j - 1, game_state->board[i][j]);
+			}
+		}
+	}
+
+	// Every occupied slot sits alone on a cell of its own team
+	memset(owner, -1, sizeof(owner));
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		position_t pos = game_state->players[slot];
+		team = game_state->player_teams[slot];
+		if (team == 0) {
+			if (pos.x != -1 || pos.y != -1) {
+				VIOLATION("free slot %d still at (%d,%d)", slot, pos.x, pos.y);
+			}
+			continue;
+		}
+		if (team < 0 || team > MAX_TEAMS || !is_valid_position(pos.x, pos.y)) {
+			VIOLATION("slot %d has team %d at (%d,%d)", slot, team, pos.x, pos.y);
+			continue;
+		}
+		if (game_state->eliminated[slot]) {
+			VIOLATION("slot %d is eliminated but still on the board", slot);
+		}
+		if (BOARD_CELL(game_state, pos.x, pos.y) != team) {
+			VIOLATION("slot %d of team %d at (%d,%d) but the cell holds %d", slot, team,
+					  pos.x, pos.y, BOARD_CELL(game_state, pos.x, pos.y));
+		}
+		if (owner[pos.x][pos.y] != -1) {
+			VIOLATION("slots %d and %d both at (%d,%d)", owner[pos.x][pos.y], slot, pos.x, pos.y);
+		}
+		owner[pos.x][pos.y] = slot;
+	}
+
+	// Every occupied cell belongs to a slot, and the counters match the cells
+	memset(cells, 0, sizeof(cells));
+	for (i = 0; i < BOARD_SIZE; i++) {
+		for (j = 0; j < BOARD_SIZE; j++) {
+			team = BOARD_CELL(game_state, i, j);
+			if (team == EMPTY_CELL) {
+				continue;
+			}
+			if (team < 0 || team > MAX_TEAMS) {
+				VIOLATION("cell (%d,%d) holds %d", i, j, team);
+				continue;
+			}
+			if (owner[i][j] == -1) {
+				VIOLATION("cell (%d,%d) of team %d has no slot", i, j, team);
+			}
+			cells[team]++;
+		}
+	}
+
+	int total = 0;
+	int alive = 0;
+	for (team = 1; team <= MAX_TEAMS; team++) {
+		if (game_state->team_counts[team] != cells[team]) {
+			VIOLATION("team_counts[%d] is %d but the board has %d", team,
+					  game_state->team_counts[team], cells[team]);
+		}
+		total += cells[team];
+		alive += (cells[team] > 0);
+	}
+	if (game_state->player_count != total) {
+		VIOLATION("player_count is %d but the board has %d", game_state->player_count, total);
+	}
+	if (game_state->teams_alive != alive) {
+		VIOLATION("teams_alive is %d but the board has %d", game_state->teams_alive, alive);
+	}
+
+#undef VIOLATION
+	return violations;
 }
 
 int is_game_over(game_state_t *game_state) {
 	// Game over only if no players remain
 	// OR if only one team remains AND game has been running for at least 10 seconds
+	// An arena nobody has joined yet is not over: services such as the
+	// arbiter start sweeping before the launcher has placed anyone
 	int game_duration = time(NULL) - game_state->game_start_time;
-	return (game_state->player_count == 0 || 
-			(game_state->teams_alive <= 1 && game_state->player_count > 0 && game_duration >= 10));
+	return ((game_state->player_count == 0 && game_state->total_joins > 0) || 
+			(game_state->teams_alive <= 1 && game_state->player_count > 0 &&
+			 game_duration >= MIN_GAME_SECONDS));
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "game.h"
+
+// Checkpoint file layout: a checkpoint_header_t, the raw game_state_t, then
+// message_count queued message_t records. The state is copied in a single
+// memcpy under SEM_BOARD, so players only stall for that long; the file is
+// written afterwards and renamed into place so a crash never leaves a torn
+// checkpoint behind.
+
+#define CHECKPOINT_MAGIC 0x434d454c
+#define CHECKPOINT_VERSION 2
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t state_size;
+	uint32_t board_size;
+	uint32_t max_teams;
+	uint32_t max_players_per_team;
+	uint32_t message_count;
+	uint32_t reserved;
+	int64_t saved_at;
+} checkpoint_header_t;
+
+// Peek at the queued messages without taking them off the queue, so the
+// players keep receiving them while we save. MSG_COPY needs a kernel built
+// with CONFIG_CHECKPOINT_RESTORE; without it the checkpoint carries no
+// messages rather than disturbing the queue.
+static message_t *copy_messages(player_t *arena, uint32_t *count) {
+	struct msqid_ds info;
+	message_t *messages;
+	msgqnum_t i;
+
+	*count = 0;
+	if (msgctl(arena->msg_id, IPC_STAT, &info) == -1) {
+		perror("msgctl");
+		return NULL;
+	}
+	if (info.msg_qnum == 0) {
+		return NULL;
+	}
+
+	messages = malloc(info.msg_qnum * sizeof(message_t));
+	if (messages == NULL) {
+		perror("malloc");
+		return NULL;
+	}
+
+	// The queue may shrink under us, ENOMSG just ends the copy early
+	for (i = 0; i < info.msg_qnum; i++) {
+		if (msgrcv(arena->msg_id, &messages[*count], sizeof(message_t) - sizeof(long),
+				   i, MSG_COPY | IPC_NOWAIT) == -1) {
+			if (errno == ENOSYS) {
+				fprintf(stderr, "Warning: kernel cannot copy queued messages, saving none\n");
+				*count = 0;
+			} else if (errno != ENOMSG) {
+				perror("msgrcv");
+			}
+			break;
+		}
+		(*count)++;
+	}
+	return messages;
+}
+
+static int write_all(int fd, const void *data, size_t size) {
+	const char *bytes = data;
+	while (size > 0) {
+		ssize_t n = write(fd, bytes, size);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		bytes += n;
+		size -= n;
+	}
+	return 0;
+}
+
+int checkpoint_arena(player_t *arena, const char *path) {
+	checkpoint_header_t header;
+	char tmp_path[4096];
+	game_state_t *state = malloc(sizeof(game_state_t));
+	int result = 0;
+
+	if (state == NULL) {
+		perror("malloc");
+		return -1;
+	}
+
+	sem_lock(arena->sem_id, SEM_BOARD);
+	memcpy(state, arena->game_state, sizeof(game_state_t));
+	sem_unlock(arena->sem_id, SEM_BOARD);
+
+	memset(&header, 0, sizeof(header));
+	header.magic = CHECKPOINT_MAGIC;
+	header.version = CHECKPOINT_VERSION;
+	header.state_size = sizeof(game_state_t);
+	header.board_size = BOARD_SIZE;
+	header.max_teams = MAX_TEAMS;
+	header.max_players_per_team = MAX_PLAYERS_PER_TEAM;
+	header.saved_at = time(NULL);
+	message_t *messages = copy_messages(arena, &header.message_count);
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		perror("open");
+		result = -1;
+	} else {
+		if (write_all(fd, &header, sizeof(header)) == -1 ||
+			write_all(fd, state, sizeof(game_state_t)) == -1 ||
+			write_all(fd, messages, header.message_count * sizeof(message_t)) == -1 ||
+			fsync(fd) == -1) {
+			perror("write");
+			result = -1;
+		}
+		close(fd);
+		if (result == 0 && rename(tmp_path, path) == -1) {
+			perror("rename");
+			result = -1;
+		}
+		if (result == -1) {
+			unlink(tmp_path);
+		}
+	}
+
+	free(messages);
+	free(state);
+	return result;
+}
+
+// Load a checkpoint into a freshly created arena. The processes that owned
+// the saved players are gone, so their slots stay on the board as orphans
+// until players of the same team rejoin them (see place_player), for at
+// most ORPHAN_GRACE_SECONDS (see expire_orphans).
+int restore_arena(player_t *player, const char *path) {
+	struct stat st;
+	uint32_t i;
+	int slot;
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		perror("open");
+		return -1;
+	}
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(checkpoint_header_t)) {
+		fprintf(stderr, "%s: not a checkpoint\n", path);
+		close(fd);
+		return -1;
+	}
+
+	char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+
+	const checkpoint_header_t *header = (const checkpoint_header_t *)data;
+	size_t expected = sizeof(checkpoint_header_t) + sizeof(game_state_t) +
+					  (size_t)header->message_count * sizeof(message_t);
+	if (header->magic != CHECKPOINT_MAGIC || header->version != CHECKPOINT_VERSION ||
+		header->state_size != sizeof(game_state_t) || header->board_size != BOARD_SIZE ||
+		header->max_teams != MAX_TEAMS ||
+		header->max_players_per_team != MAX_PLAYERS_PER_TEAM ||
+		(size_t)st.st_size != expected) {
+		fprintf(stderr, "%s: checkpoint does not match this build\n", path);
+		munmap(data, st.st_size);
+		return -1;
+	}
+
+	game_state_t *game_state = player->game_state;
+	sem_lock(player->sem_id, SEM_BOARD);
+	// Everything but the magic, which is stamped last like in init_board:
+	// joiners wait for it before reading the rest of the layout
+	const char *saved = data + sizeof(checkpoint_header_t);
+	memcpy((char *)game_state + sizeof(game_state->magic), saved + sizeof(game_state->magic),
+		   sizeof(game_state_t) - sizeof(game_state->magic));
+
+	// Drop everything that belonged to processes of the old arena
+	memset(&game_state->lockstep, 0, sizeof(lockstep_t));
+	game_state->arbiter_pid = 0;
+	game_state->arbiter_alive_until = 0;
+	game_state->referee_pid = 0;
+	game_state->referee_alive_until = 0;
+	game_state->epoch = 0;
+	game_state->notify_seq = 0;
+	game_state->game_start_time += time(NULL) - header->saved_at;
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		game_state->intents[slot].pending = 0;
+		game_state->orphaned[slot] = (game_state->player_teams[slot] != 0);
+		game_state->eliminated[slot] = 0;
+		game_state->slot_owners[slot] = 0;
+	}
+	game_state->orphans_expire_at = time(NULL) + ORPHAN_GRACE_SECONDS;
+	__atomic_store_n(&game_state->magic, ARENA_MAGIC, __ATOMIC_RELEASE);
+	sem_unlock(player->sem_id, SEM_BOARD);
+
+	const message_t *messages = (const message_t *)(data + sizeof(checkpoint_header_t) +
+													sizeof(game_state_t));
+	for (i = 0; i < header->message_count; i++) {
+		message_t msg = messages[i];
+		if (msgsnd(player->msg_id, &msg, sizeof(message_t) - sizeof(long), IPC_NOWAIT) == -1) {
+			perror("msgsnd");
+			break;
+		}
+	}
+
+	munmap(data, st.st_size);
+	return 0;
+}
@@ -0,0 +1,285 @@
+#include "game.h"
+
+// Streams the board to local subscribers over a Unix domain socket. The
+// exporter is the only one reading the shared segment: once per interval it
+// copies the board under SEM_BOARD, diffs it against the previous copy and
+// sends the changed cells. New subscribers start with a keyframe. A
+// subscriber whose buffer cannot take the next delta skips deltas until its
+// buffer has drained, then gets a fresh keyframe.
+
+#define EXPORT_MAX_CLIENTS 32
+#define EXPORT_CLIENT_BUFFER (4 * (sizeof(frame_header_t) + BOARD_SIZE * BOARD_SIZE))
+
+typedef struct {
+	int fd;
+	int needs_keyframe;
+	size_t pending;
+	size_t sent;
+	char buffer[EXPORT_CLIENT_BUFFER];
+} subscriber_t;
+
+typedef struct {
+	uint8_t board[BOARD_SIZE][BOARD_SIZE];
+	frame_header_t counters;
+} board_snapshot_t;
+
+static volatile sig_atomic_t g_export_stop = 0;
+
+static void export_signal_handler(int sig) {
+	(void)sig;
+	g_export_stop = 1;
+}
+
+static int open_socket(const char *socket_path) {
+	struct sockaddr_un addr;
+	struct stat st;
+	int stale = 0;
+	int fd;
+
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path too long: %s\n", socket_path);
+		return -1;
+	}
+	// Only replace a stale socket, never a file a mistyped path points at
+	if (lstat(socket_path, &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			fprintf(stderr, "%s exists and is not a socket\n", socket_path);
+			return -1;
+		}
+		stale = 1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		perror("socket");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, socket_path);
+	if (stale) {
+		unlink(socket_path);
+	}
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, 16) == -1) {
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+// Copy the board under SEM_BOARD. Returns 1 once the arena has been removed:
+// the last player is gone, so the segment we still have mapped is read as is
+// and becomes the final frame.
+static int take_snapshot(player_t *arena, board_snapshot_t *snapshot) {
+	game_state_t *game_state = arena->game_state;
+	struct sembuf lock = {SEM_BOARD, -1, 0};
+	struct sembuf unlock = {SEM_BOARD, 1, 0};
+	int removed = 0;
+	int i, j;
+
+	while (semop(arena->sem_id, &lock, 1) == -1) {
+		if (errno == EINVAL || errno == EIDRM) {
+			removed = 1;
+			break;
+		}
+		if (errno != EINTR) {
+			perror("semop lock");
+			removed = 1;
+			break;
+		}
+	}
+	for (i = 0; i < BOARD_SIZE; i++) {
+		for (j = 0; j < BOARD_SIZE; j++) {
+			snapshot->board[i][j] = BOARD_CELL(game_state, i, j);
+		}
+	}
+	snapshot->counters.game_over = game_state->game_over;
+	snapshot->counters.player_count = game_state->player_count;
+	snapshot->counters.teams_alive = game_state->teams_alive;
+	snapshot->counters.total_kills = game_state->total_kills;
+	for (i = 0; i <= MAX_TEAMS; i++) {
+		snapshot->counters.team_counts[i] = game_state->team_counts[i];
+	}
+	if (!removed) {
+		semop(arena->sem_id, &unlock, 1);
+	}
+	return removed;
+}
+
+// Encode the changes between two snapshots, returns the frame size
+static size_t encode_delta(const board_snapshot_t *previous, const board_snapshot_t *current,
+						   uint32_t seq, char *frame) {
+	frame_header_t *header = (frame_header_t *)frame;
+	cell_change_t *changes = (cell_change_t *)(frame + sizeof(frame_header_t));
+	uint32_t count = 0;
+	int i, j;
+
+	for (i = 0; i < BOARD_SIZE; i++) {
+		for (j = 0; j < BOARD_SIZE; j++) {
+			if (current->board[i][j] != previous->board[i][j]) {
+				changes[count].x = i;
+				changes[count].y = j;
+				changes[count].team = current->board[i][j];
+				count++;
+			}
+		}
+	}
+
+	*header = current->counters;
+	header->type = FRAME_DELTA;
+	header->board_size = BOARD_SIZE;
+	header->seq = seq;
+	header->count = count;
+	return sizeof(frame_header_t) + count * sizeof(cell_change_t);
+}
+
+static size_t encode_keyframe(const board_snapshot_t *current, uint32_t seq, char *frame) {
+	frame_header_t *header = (frame_header_t *)frame;
+
+	*header = current->counters;
+	header->type = FRAME_KEY;
+	header->board_size = BOARD_SIZE;
+	header->seq = seq;
+	header->count = BOARD_SIZE * BOARD_SIZE;
+	memcpy(frame + sizeof(frame_header_t), current->board, sizeof(current->board));
+	return sizeof(frame_header_t) + sizeof(current->board);
+}
+
+static void queue_frame(subscriber_t *client, const char *frame, size_t size) {
+	memcpy(client->buffer + client->pending, frame, size);
+	client->pending += size;
+}
+
+// Returns -1 if the subscriber went away
+static int flush_client(subscriber_t *client) {
+	while (client->sent < client->pending) {
+		ssize_t n = send(client->fd, client->buffer + client->sent,
+						 client->pending - client->sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (n == -1) {
+			return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+		}
+		client->sent += n;
+	}
+	client->pending = 0;
+	client->sent = 0;
+	return 0;
+}
+
+// Serve subscribers until the game ends or a signal arrives
+int export_board(player_t *arena, const char *socket_path, int interval_ms) {
+	subscriber_t *clients = calloc(EXPORT_MAX_CLIENTS, sizeof(subscriber_t));
+	board_snapshot_t *snapshots = calloc(2, sizeof(board_snapshot_t));
+	char *delta = malloc(sizeof(frame_header_t) + BOARD_SIZE * BOARD_SIZE * sizeof(cell_change_t));
+	char *keyframe = malloc(sizeof(frame_header_t) + BOARD_SIZE * BOARD_SIZE);
+	int client_count = 0;
+	uint32_t seq = 0;
+	int i;
+
+	if (clients == NULL || snapshots == NULL || delta == NULL || keyframe == NULL) {
+		perror("malloc");
+		free(clients);
+		free(snapshots);
+		free(delta);
+		free(keyframe);
+		return -1;
+	}
+
+	int listen_fd = open_socket(socket_path);
+	if (listen_fd == -1) {
+		free(clients);
+		free(snapshots);
+		free(delta);
+		free(keyframe);
+		return -1;
+	}
+
+	signal(SIGINT, export_signal_handler);
+	signal(SIGTERM, export_signal_handler);
+	signal(SIGQUIT, export_signal_handler);
+	signal(SIGPIPE, SIG_IGN);
+
+	board_snapshot_t *previous = &snapshots[0];
+	board_snapshot_t *current = &snapshots[1];
+	int ended = take_snapshot(arena, previous);
+
+	while (!g_export_stop && !ended) {
+		int fd;
+		while (client_count < EXPORT_MAX_CLIENTS &&
+			   (fd = accept(listen_fd, NULL, NULL)) != -1) {
+			memset(&clients[client_count], 0, sizeof(subscriber_t));
+			clients[client_count].fd = fd;
+			clients[client_count].needs_keyframe = 1;
+			client_count++;
+		}
+
+		ended = take_snapshot(arena, current);
+		seq++;
+
+		size_t delta_size = 0;
+		size_t keyframe_size = 0;
+		if (memcmp(current, previous, sizeof(board_snapshot_t)) != 0) {
+			delta_size = encode_delta(previous, current, seq, delta);
+		}
+
+		for (i = 0; i < client_count; i++) {
+			subscriber_t *client = &clients[i];
+
+			if (client->needs_keyframe) {
+				// Only restart a lagging subscriber once it has caught up
+				if (client->pending == 0) {
+					if (keyframe_size == 0) {
+						keyframe_size = encode_keyframe(current, seq, keyframe);
+					}
+					queue_frame(client, keyframe, keyframe_size);
+					client->needs_keyframe = 0;
+				}
+			} else if (delta_size > 0) {
+				if (client->pending + delta_size <= EXPORT_CLIENT_BUFFER) {
+					queue_frame(client, delta, delta_size);
+				} else {
+					client->needs_keyframe = 1;
+				}
+			}
+
+			if (flush_client(client) == -1) {
+				close(client->fd);
+				clients[i] = clients[--client_count];
+				i--;
+			}
+		}
+
+		board_snapshot_t *swap = previous;
+		previous = current;
+		current = swap;
+
+		if (previous->counters.game_over || ended) {
+			break;
+		}
+		usleep(interval_ms * 1000);
+	}
+
+	// Give every subscriber a moment to take the last frames
+	for (i = 0; i < client_count; i++) {
+		int tries;
+		for (tries = 0; tries < 100 && clients[i].pending > 0; tries++) {
+			if (flush_client(&clients[i]) == -1) {
+				break;
+			}
+			if (clients[i].pending > 0) {
+				usleep(1000);
+			}
+		}
+		close(clients[i].fd);
+	}
+	close(listen_fd);
+	unlink(socket_path);
+	free(clients);
+	free(snapshots);
+	free(delta);
+	free(keyframe);
+	return 0;
+}
@@ -2,7 +2,11 @@
 
 void sem_lock(int sem_id, int sem_num) {
 	struct sembuf sb = {sem_num, -1, 0};
-	if (semop(sem_id, &sb, 1) == -1) {
+	while (semop(sem_id, &sb, 1) == -1) {
+		// Signal handlers only set stop flags, keep waiting for the lock
+		if (errno == EINTR) {
+			continue;
+		}
 		perror("semop lock");
 		exit(EXIT_FAILURE);
 	}
@@ -43,10 +47,13 @@ static int create_semaphore(key_t key) {
 	return sem_id;
 }
 
-static int create_shared_memory(key_t key) {
+// Sets *created when this call made the segment, rather than losing a race
+// with another first player
+static int create_shared_memory(key_t key, int *created) {
 	int shm_id = shmget(key, sizeof(game_state_t), IPC_CREAT | IPC_EXCL | 0666);
+	*created = (shm_id != -1);
 	if (shm_id == -1 && errno == EEXIST) {
-		shm_id = shmget(key, sizeof(game_state_t), 0666);
+		shm_id = shmget(key, 0, 0666);
 	}
 	if (shm_id == -1) {
 		perror("shmget");
@@ -67,13 +74,48 @@ static int create_message_queue(key_t key) {
 	return msg_id;
 }
 
+// Make sure an existing arena was laid out by a build with the same
+// dimensions. Returns -1 if it was not.
+static int check_arena_layout(player_t *player) {
+	game_state_t *game_state = player->game_state;
+	struct shmid_ds info;
+	int waited_ms;
+	
+	if (shmctl(player->shm_id, IPC_STAT, &info) == -1) {
+		perror("shmctl stat");
+		return -1;
+	}
+	if (info.shm_segsz != sizeof(game_state_t)) {
+		fprintf(stderr, "Arena is %zu bytes but this build expects %zu, "
+				"was it started with other BOARD_SIZE or PLAYERS_PER_TEAM values?\n",
+				(size_t)info.shm_segsz, sizeof(game_state_t));
+		return -1;
+	}
+	
+	// The creator stamps the arena right after creating it
+	for (waited_ms = 0; waited_ms < 1000; waited_ms += 10) {
+		if (__atomic_load_n(&game_state->magic, __ATOMIC_ACQUIRE) != 0) {
+			break;
+		}
+		usleep(10000);
+	}
+	if (game_state->magic != ARENA_MAGIC || game_state->state_size != sizeof(game_state_t) ||
+		game_state->board_size != BOARD_SIZE ||
+		game_state->max_players_per_team != MAX_PLAYERS_PER_TEAM) {
+		fprintf(stderr, "Arena layout does not match this build (board %d, %d players per team)\n",
+				BOARD_SIZE, MAX_PLAYERS_PER_TEAM);
+		return -1;
+	}
+	return 0;
+}
+
 void init_ipc(player_t *player) {
 	int is_first_player = 0;
 	
-	player->shm_id = shmget(SHM_KEY, sizeof(game_state_t), 0666);
+	// Look the segment up by key only, so a size mismatch is reported below
+	player->shm_id = shmget(SHM_KEY, 0, 0666);
 	if (player->shm_id == -1) {
-		is_first_player = 1;
-		player->shm_id = create_shared_memory(SHM_KEY);
+		player->shm_id = create_shared_memory(SHM_KEY, &is_first_player);
 	}
 	
 	player->game_state = shmat(player->shm_id, NULL, 0);
@@ -82,16 +124,64 @@ void init_ipc(player_t *player) {
 		exit(EXIT_FAILURE);
 	}
 	
+	if (!is_first_player && check_arena_layout(player) == -1) {
+		shmdt(player->game_state);
+		exit(EXIT_FAILURE);
+	}
+	// Restoring into a live game would silently join it instead
+	if (!is_first_player && player->restore_path != NULL) {
+		fprintf(stderr, "An arena is already running, stop it before restoring %s\n",
+				player->restore_path);
+		shmdt(player->game_state);
+		exit(EXIT_FAILURE);
+	}
+	
 	player->msg_id = create_message_queue(MSG_KEY);
 	player->sem_id = create_semaphore(SEM_KEY);
 	
-	if (is_first_player) {
+	if (is_first_player && player->restore_path != NULL) {
+		if (restore_arena(player, player->restore_path) == -1) {
+			fprintf(stderr, "Could not restore arena from %s\n", player->restore_path);
+			destroy_ipc(player);
+			exit(EXIT_FAILURE);
+		}
+	} else if (is_first_player) {
 		sem_lock(player->sem_id, SEM_BOARD);
 		init_board(player->game_state);
 		sem_unlock(player->sem_id, SEM_BOARD);
 	}
 }
 
+// Attach to a running arena without creating anything, for observers and
+// tools. Returns -1 if no arena exists.
+int attach_ipc(player_t *player) {
+	player->shm_id = shmget(SHM_KEY, 0, 0666);
+	player->msg_id = msgget(MSG_KEY, 0666);
+	player->sem_id = semget(SEM_KEY, SEM_COUNT, 0666);
+	if (player->shm_id == -1 || player->msg_id == -1 || player->sem_id == -1) {
+		return -1;
+	}
+	
+	player->game_state = shmat(player->shm_id, NULL, 0);
+	if (player->game_state == (void *)-1) {
+		perror("shmat");
+		player->game_state = NULL;
+		return -1;
+	}
+	if (check_arena_layout(player) == -1) {
+		shmdt(player->game_state);
+		player->game_state = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+// Returns 1 if any of the arena's IPC objects is still around
+int arena_exists(void) {
+	return (shmget(SHM_KEY, 0, 0) != -1 || msgget(MSG_KEY, 0) != -1 ||
+			semget(SEM_KEY, 0, 0) != -1);
+}
+
 void cleanup_ipc(player_t *player) {
 	if (player->game_state == NULL) {
 		return; // Already cleaned up
@@ -105,7 +195,12 @@ void cleanup_ipc(player_t *player) {
 	struct sembuf sb = {SEM_BOARD, -1, 0};
 	if (semtimedop(player->sem_id, &sb, 1, &timeout) == 0) {
 		// Don't decrement again - remove_player already did this!
+		// Restored slots nobody adopted have no process behind them
 		int remaining_players = player->game_state->player_count;
+		int slot;
+		for (slot = 0; slot < MAX_PLAYERS; slot++) {
+			remaining_players -= player->game_state->orphaned[slot];
+		}
 		
 		struct sembuf sb_unlock = {SEM_BOARD, 1, 0};
 		semop(player->sem_id, &sb_unlock, 1);
@@ -131,14 +226,40 @@ void cleanup_ipc(player_t *player) {
 		}
 	} else {
 		// Timeout or error - force cleanup if we're likely the last process
+		destroy_ipc(player);
+	}
+}
+
+void destroy_ipc(player_t *player) {
+	if (player->game_state != NULL) {
 		if (shmdt(player->game_state) == -1) {
 			perror("shmdt");
 		}
 		player->game_state = NULL;
-		
-		// Attempt cleanup anyway - if it fails, resources might be already cleaned
-		shmctl(player->shm_id, IPC_RMID, NULL);
-		msgctl(player->msg_id, IPC_RMID, NULL);
-		semctl(player->sem_id, 0, IPC_RMID);
 	}
-}
\ No newline at end of file
+	
+	// Attempt cleanup anyway - if it fails, resources might be already cleaned
+	shmctl(player->shm_id, IPC_RMID, NULL);
+	msgctl(player->msg_id, IPC_RMID, NULL);
+	semctl(player->sem_id, 0, IPC_RMID);
+}
+
+// Wake every player sleeping in arena_wait. The futex word lives in the
+// shared segment, so the wake-up crosses process boundaries.
+void arena_notify(game_state_t *game_state) {
+	__atomic_add_fetch(&game_state->notify_seq, 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &game_state->notify_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// Sleep up to timeout_usec, returning early once notify_seq moves past `seq`
+void arena_wait(game_state_t *game_state, unsigned int seq, int timeout_usec) {
+	struct timespec timeout;
+	timeout.tv_sec = timeout_usec / 1000000;
+	timeout.tv_nsec = (timeout_usec % 1000000) * 1000L;
+	
+	if (syscall(SYS_futex, &game_state->notify_seq, FUTEX_WAIT, seq, &timeout, NULL, 0) == -1 &&
+		errno != EAGAIN && errno != ETIMEDOUT && errno != EINTR) {
+		perror("futex wait");
+		usleep(timeout_usec);
+	}
+}
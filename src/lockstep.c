@@ -0,0 +1,174 @@
+#include "game.h"
+
+// Lockstep ticks run in two phases. Between barriers nobody writes the board,
+// so every participant plans from the same snapshot without locking. The last
+// player to reach the barrier commits all intents, resolves kills and releases
+// the others. Waiters sleep on the tick semaphore matching the generation
+// parity, so a fast player arriving at the next barrier can never consume a
+// wake-up meant for a slow player of the previous one.
+
+static int tick_semaphore(unsigned int generation) {
+	return (generation & 1) ? SEM_TICK_ODD : SEM_TICK_EVEN;
+}
+
+void lockstep_enable(game_state_t *game_state, unsigned int seed, int tick_usec) {
+	memset(&game_state->lockstep, 0, sizeof(lockstep_t));
+	game_state->lockstep.enabled = 1;
+	game_state->lockstep.seed = seed;
+	game_state->lockstep.tick_usec = tick_usec;
+	// MIN_GAME_SECONDS worth of ticks, ticks under 1ms counting as 1ms
+	game_state->lockstep.min_ticks = MIN_GAME_SECONDS * 1000000U /
+									 (tick_usec > 1000 ? tick_usec : 1000);
+}
+
+// Same rule as is_game_over, but counted in ticks rather than wall time so
+// a replay ends on the same tick
+static int lockstep_game_over(game_state_t *game_state) {
+	return (game_state->player_count == 0 ||
+			(game_state->teams_alive <= 1 &&
+			 game_state->lockstep.generation >= game_state->lockstep.min_ticks));
+}
+
+void lockstep_join(player_t *player) {
+	sem_lock(player->sem_id, SEM_BOARD);
+	player->game_state->lockstep.participants++;
+	player->game_state->lockstep.joined[player->player_id] = 1;
+	sem_unlock(player->sem_id, SEM_BOARD);
+}
+
+// Commit phase. Caller must hold SEM_BOARD and be the last arrival.
+static void commit_tick(player_t *player) {
+	game_state_t *game_state = player->game_state;
+	lockstep_t *lockstep = &game_state->lockstep;
+	int released = 0;
+	int slot;
+
+	apply_move_intents(game_state);
+	// Victims stay participants until they have taken their wake-up and
+	// left, so the next commit cannot happen, and nobody can wait on this
+	// parity again, while one of its tokens is still on the semaphore
+	resolve_kills(game_state);
+
+	if (lockstep_game_over(game_state)) {
+		game_state->game_over = 1;
+	}
+
+	int tick_sem = tick_semaphore(lockstep->generation);
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		if (lockstep->waiting[slot]) {
+			lockstep->waiting[slot] = 0;
+			lockstep->released_on[slot] = tick_sem;
+			released++;
+		}
+	}
+
+	// Add rather than set: every token is taken by its owner, in
+	// lockstep_arrive or lockstep_leave, so none is ever lost
+	struct sembuf release = {tick_sem, released, 0};
+	if (released > 0 && semop(player->sem_id, &release, 1) == -1) {
+		perror("semop tick");
+	}
+
+	lockstep->arrived = 0;
+	lockstep->generation++;
+}
+
+// Publish this tick's intent and wait for the commit
+static void lockstep_arrive(player_t *player, position_t target) {
+	game_state_t *game_state = player->game_state;
+	lockstep_t *lockstep = &game_state->lockstep;
+
+	sem_lock(player->sem_id, SEM_BOARD);
+
+	game_state->intents[player->player_id].target = target;
+	game_state->intents[player->player_id].pending = (target.x != -1);
+	lockstep->arrived++;
+
+	if (lockstep->arrived >= lockstep->participants) {
+		commit_tick(player);
+		sem_unlock(player->sem_id, SEM_BOARD);
+		return;
+	}
+
+	int tick_sem = tick_semaphore(lockstep->generation);
+	lockstep->waiting[player->player_id] = 1;
+	sem_unlock(player->sem_id, SEM_BOARD);
+
+	sem_lock(player->sem_id, tick_sem);
+	lockstep->released_on[player->player_id] = 0;
+}
+
+void lockstep_leave(player_t *player) {
+	game_state_t *game_state = player->game_state;
+	lockstep_t *lockstep = &game_state->lockstep;
+
+	sem_lock(player->sem_id, SEM_BOARD);
+
+	// A wake-up left on the semaphore would let a later waiter of that
+	// parity through before its commit
+	int owed = lockstep->released_on[player->player_id];
+	if (owed != 0) {
+		struct sembuf take = {owed, -1, IPC_NOWAIT};
+		if (semop(player->sem_id, &take, 1) == -1) {
+			perror("semop tick");
+		}
+		lockstep->released_on[player->player_id] = 0;
+	}
+
+	if (lockstep->joined[player->player_id]) {
+		lockstep->joined[player->player_id] = 0;
+		if (lockstep->waiting[player->player_id]) {
+			lockstep->waiting[player->player_id] = 0;
+			lockstep->arrived--;
+		}
+		lockstep->participants--;
+		// Kill victims are already off the board. Our local pos may predate
+		// the last commit.
+		if (!game_state->eliminated[player->player_id]) {
+			clear_player_slot(game_state, player->player_id,
+							  game_state->players[player->player_id], player->team);
+			game_state->eliminated[player->player_id] = 1;
+		}
+
+		// Everyone still in the game may already be waiting on us
+		if (!game_state->game_over && lockstep->arrived > 0 &&
+			lockstep->arrived >= lockstep->participants) {
+			commit_tick(player);
+		}
+	}
+
+	sem_unlock(player->sem_id, SEM_BOARD);
+}
+
+void lockstep_game_loop(player_t *player, int display_mode) {
+	game_state_t *game_state = player->game_state;
+	unsigned int seed = game_state->lockstep.seed + player->player_id;
+
+	while (!game_state->game_over && !player_stop_requested()) {
+		if (display_mode) {
+			display_board(game_state, player->sem_id);
+		}
+
+		usleep(game_state->lockstep.tick_usec);
+
+		// Decision phase: the board is frozen until everyone has arrived
+		position_t next = plan_move(player, &seed);
+		lockstep_arrive(player, next);
+
+		if (game_state->eliminated[player->player_id]) {
+			printf("💀 Player %d from team %d has been eliminated!\n",
+				   player->player_id, player->team);
+			return;
+		}
+		player->pos = game_state->players[player->player_id];
+	}
+
+	if (display_mode) {
+		display_board(game_state, player->sem_id);
+	}
+
+	if (game_state->game_over) {
+		printf("Game over! Player %d from team %d exiting.\n",
+			   player->player_id, player->team);
+	}
+}
@@ -0,0 +1,353 @@
+#include "game.h"
+
+// Lookahead planner. The board is copied once under SEM_BOARD, then every
+// candidate first move is searched on a small worker pool against private
+// copies of that snapshot. The search alternates our moves with the most
+// dangerous single enemy step inside a window around the player, and deepens
+// one ply at a time until the per-move time budget runs out. The kill rule is
+// the one from count_adjacent_enemies.
+
+#define LOOKAHEAD_WORKERS 4
+#define LOOKAHEAD_RADIUS 3
+#define LOOKAHEAD_MAX_PLIES 8
+#define LOOKAHEAD_CANDIDATES 5
+
+#define SCORE_DEAD (-100000)
+#define SCORE_KILL 100
+#define SCORE_SUPPORT 5
+
+static const int STEP_DX[] = {0, -1,  0, 0, 1};
+static const int STEP_DY[] = {0,  0, -1, 1, 0};
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t work_ready;
+	pthread_cond_t work_done;
+	pthread_mutex_t caller_lock;
+	unsigned int generation;
+	int workers;
+
+	// Current job
+	game_state_t *root;
+	position_t origin;
+	int team;
+	int depth;
+	struct timespec deadline;
+	position_t candidates[LOOKAHEAD_CANDIDATES];
+	int scores[LOOKAHEAD_CANDIDATES];
+	int aborted;
+	int candidate_count;
+	int next_candidate;
+	int finished;
+
+	game_state_t *scratch[LOOKAHEAD_WORKERS];
+	pthread_t threads[LOOKAHEAD_WORKERS];
+} worker_pool_t;
+
+static worker_pool_t g_pool;
+static pthread_once_t g_pool_once = PTHREAD_ONCE_INIT;
+
+static int past_deadline(const struct timespec *deadline) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec > deadline->tv_sec ||
+			(now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec));
+}
+
+static int on_board(int x, int y) {
+	return (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE);
+}
+
+static int in_window(int x, int y, position_t center, int radius) {
+	return (on_board(x, y) && abs(x - center.x) <= radius && abs(y - center.y) <= radius);
+}
+
+// Static score of a board from the point of view of the player at `me`
+static int evaluate(game_state_t *board, int team, position_t me) {
+	int nearest = BOARD_SIZE * 2;
+	int score = 0;
+	int i, j;
+
+	for (i = me.x - LOOKAHEAD_RADIUS; i <= me.x + LOOKAHEAD_RADIUS; i++) {
+		for (j = me.y - LOOKAHEAD_RADIUS; j <= me.y + LOOKAHEAD_RADIUS; j++) {
+			if (!in_window(i, j, me, LOOKAHEAD_RADIUS)) {
+				continue;
+			}
+			int cell = BOARD_CELL(board, i, j);
+			if (cell == EMPTY_CELL) {
+				continue;
+			}
+			int dist = abs(i - me.x) + abs(j - me.y);
+			if (cell != team) {
+				if (count_adjacent_enemies(board, cell, i, j) >= 2) {
+					score += SCORE_KILL;
+				}
+				if (dist < nearest) {
+					nearest = dist;
+				}
+			} else if (dist > 0 && abs(i - me.x) <= 1 && abs(j - me.y) <= 1) {
+				score += SCORE_SUPPORT;
+			}
+		}
+	}
+
+	return score - nearest * 2;
+}
+
+static int search(game_state_t *board, int team, position_t me, int depth, int our_turn,
+				  const struct timespec *deadline, int *aborted) {
+	int best, s, i, x, y;
+
+	if (*aborted || past_deadline(deadline)) {
+		*aborted = 1;
+		return 0;
+	}
+	if (count_adjacent_enemies(board, team, me.x, me.y) >= 2) {
+		// Dying later beats dying now
+		return SCORE_DEAD - depth;
+	}
+	if (depth == 0) {
+		return evaluate(board, team, me);
+	}
+
+	if (our_turn) {
+		best = search(board, team, me, depth - 1, 0, deadline, aborted);
+		for (i = 1; i < LOOKAHEAD_CANDIDATES; i++) {
+			position_t to = {me.x + STEP_DX[i], me.y + STEP_DY[i]};
+			// Off-board steps land on the wall border, which is never empty
+			if (BOARD_CELL(board, to.x, to.y) != EMPTY_CELL) {
+				continue;
+			}
+			BOARD_CELL(board, me.x, me.y) = EMPTY_CELL;
+			BOARD_CELL(board, to.x, to.y) = team;
+			s = search(board, team, to, depth - 1, 0, deadline, aborted);
+			BOARD_CELL(board, to.x, to.y) = EMPTY_CELL;
+			BOARD_CELL(board, me.x, me.y) = team;
+			if (s > best) {
+				best = s;
+			}
+		}
+		return best;
+	}
+
+	// Enemy ply: the single step by a nearby enemy that hurts us most
+	best = search(board, team, me, depth - 1, 1, deadline, aborted);
+	for (x = me.x - 2; x <= me.x + 2; x++) {
+		for (y = me.y - 2; y <= me.y + 2; y++) {
+			if (!in_window(x, y, me, 2)) {
+				continue;
+			}
+			int enemy = BOARD_CELL(board, x, y);
+			if (enemy == EMPTY_CELL || enemy == team) {
+				continue;
+			}
+			for (i = 1; i < LOOKAHEAD_CANDIDATES; i++) {
+				int nx = x + STEP_DX[i];
+				int ny = y + STEP_DY[i];
+				if (!in_window(nx, ny, me, LOOKAHEAD_RADIUS) ||
+					BOARD_CELL(board, nx, ny) != EMPTY_CELL) {
+					continue;
+				}
+				BOARD_CELL(board, x, y) = EMPTY_CELL;
+				BOARD_CELL(board, nx, ny) = enemy;
+				s = search(board, team, me, depth - 1, 1, deadline, aborted);
+				BOARD_CELL(board, nx, ny) = EMPTY_CELL;
+				BOARD_CELL(board, x, y) = enemy;
+				if (s < best) {
+					best = s;
+				}
+			}
+		}
+	}
+	return best;
+}
+
+static void *worker_main(void *arg) {
+	int id = (int)(long)arg;
+	game_state_t *scratch = g_pool.scratch[id];
+	unsigned int seen = 0;
+
+	pthread_mutex_lock(&g_pool.lock);
+	for (;;) {
+		while (g_pool.generation == seen) {
+			pthread_cond_wait(&g_pool.work_ready, &g_pool.lock);
+		}
+		seen = g_pool.generation;
+
+		while (g_pool.next_candidate < g_pool.candidate_count) {
+			int c = g_pool.next_candidate++;
+			position_t from = g_pool.origin;
+			position_t to = g_pool.candidates[c];
+			int team = g_pool.team;
+			int depth = g_pool.depth;
+			pthread_mutex_unlock(&g_pool.lock);
+
+			// The snapshot is read-only while a job runs
+			int aborted = 0;
+			memcpy(scratch->board, g_pool.root->board, sizeof(scratch->board));
+			BOARD_CELL(scratch, from.x, from.y) = EMPTY_CELL;
+			BOARD_CELL(scratch, to.x, to.y) = team;
+			int score = search(scratch, team, to, depth - 1, 0, &g_pool.deadline, &aborted);
+
+			pthread_mutex_lock(&g_pool.lock);
+			g_pool.scores[c] = score;
+			if (aborted) {
+				g_pool.aborted = 1;
+			}
+			if (++g_pool.finished == g_pool.candidate_count) {
+				pthread_cond_signal(&g_pool.work_done);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void pool_init(void) {
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int i;
+
+	pthread_mutex_init(&g_pool.lock, NULL);
+	pthread_mutex_init(&g_pool.caller_lock, NULL);
+	pthread_cond_init(&g_pool.work_ready, NULL);
+	pthread_cond_init(&g_pool.work_done, NULL);
+
+	g_pool.root = malloc(sizeof(game_state_t));
+	g_pool.workers = (cpus > 0 && cpus < LOOKAHEAD_WORKERS) ? (int)cpus : LOOKAHEAD_WORKERS;
+	if (g_pool.root == NULL) {
+		g_pool.workers = 0;
+		return;
+	}
+	for (i = 0; i < g_pool.workers; i++) {
+		g_pool.scratch[i] = malloc(sizeof(game_state_t));
+		if (g_pool.scratch[i] == NULL ||
+			pthread_create(&g_pool.threads[i], NULL, worker_main, (void *)(long)i) != 0) {
+			free(g_pool.scratch[i]);
+			break;
+		}
+		pthread_detach(g_pool.threads[i]);
+	}
+	g_pool.workers = i;
+}
+
+// Run one search depth over every candidate. Returns 0 if the budget ran out.
+static int run_depth(int depth) {
+	pthread_mutex_lock(&g_pool.lock);
+	g_pool.depth = depth;
+	g_pool.next_candidate = 0;
+	g_pool.finished = 0;
+	g_pool.aborted = 0;
+	g_pool.generation++;
+	pthread_cond_broadcast(&g_pool.work_ready);
+	while (g_pool.finished < g_pool.candidate_count) {
+		pthread_cond_wait(&g_pool.work_done, &g_pool.lock);
+	}
+	int completed = !g_pool.aborted;
+	pthread_mutex_unlock(&g_pool.lock);
+	return completed;
+}
+
+// Caller must hold g_pool.caller_lock
+static void start_deadline(player_t *player) {
+	clock_gettime(CLOCK_MONOTONIC, &g_pool.deadline);
+	g_pool.deadline.tv_nsec += (long)player->ai_budget_usec * 1000;
+	g_pool.deadline.tv_sec += g_pool.deadline.tv_nsec / 1000000000;
+	g_pool.deadline.tv_nsec %= 1000000000;
+}
+
+// Search the board already copied into g_pool.root. Caller must hold
+// g_pool.caller_lock.
+static int search_root(player_t *player, position_t *move) {
+	int best_scores[LOOKAHEAD_CANDIDATES];
+	int have_result = 0;
+	int i, depth;
+
+	position_t me = player->pos;
+	int enemies = 0;
+	int x, y;
+	for (x = me.x - LOOKAHEAD_RADIUS; x <= me.x + LOOKAHEAD_RADIUS; x++) {
+		for (y = me.y - LOOKAHEAD_RADIUS; y <= me.y + LOOKAHEAD_RADIUS; y++) {
+			if (in_window(x, y, me, LOOKAHEAD_RADIUS) &&
+				BOARD_CELL(g_pool.root, x, y) != EMPTY_CELL &&
+				BOARD_CELL(g_pool.root, x, y) != player->team) {
+				enemies++;
+			}
+		}
+	}
+
+	// Candidate 0 is staying put
+	g_pool.team = player->team;
+	g_pool.origin = me;
+	g_pool.candidate_count = 0;
+	for (i = 0; enemies > 0 && i < LOOKAHEAD_CANDIDATES; i++) {
+		position_t to = {me.x + STEP_DX[i], me.y + STEP_DY[i]};
+		if (i == 0 || BOARD_CELL(g_pool.root, to.x, to.y) == EMPTY_CELL) {
+			g_pool.candidates[g_pool.candidate_count++] = to;
+		}
+	}
+
+	// Iterative deepening: only a depth that finished in time is trusted
+	for (depth = 1; g_pool.candidate_count > 1 && depth <= LOOKAHEAD_MAX_PLIES; depth++) {
+		if (!run_depth(depth)) {
+			break;
+		}
+		memcpy(best_scores, g_pool.scores, sizeof(best_scores));
+		have_result = 1;
+	}
+
+	if (have_result) {
+		int best = 0;
+		for (i = 1; i < g_pool.candidate_count; i++) {
+			if (best_scores[i] > best_scores[best]) {
+				best = i;
+			}
+		}
+		*move = g_pool.candidates[best];
+		if (best == 0) {
+			move->x = -1;
+			move->y = -1;
+		}
+	}
+	return have_result;
+}
+
+// Pick a move by searching a private snapshot of the board for at most
+// player->ai_budget_usec. Returns 0 when there is no enemy around to search
+// against, so the caller can fall back to the regular planner.
+int lookahead_move(player_t *player, position_t *move) {
+	pthread_once(&g_pool_once, pool_init);
+	if (g_pool.workers == 0) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&g_pool.caller_lock);
+	start_deadline(player);
+
+	sem_lock(player->sem_id, SEM_BOARD);
+	memcpy(g_pool.root->board, player->game_state->board, sizeof(g_pool.root->board));
+	sem_unlock(player->sem_id, SEM_BOARD);
+
+	int found = search_root(player, move);
+	pthread_mutex_unlock(&g_pool.caller_lock);
+	return found;
+}
+
+// Same search, on a copy of `view` taken under `view_lock` instead of the
+// arena, for team hosts planning from their shared cache. The pool searches
+// for one thread at a time: rather than queue behind a teammate, give up and
+// let the caller fall back to its regular planner.
+int lookahead_move_from(player_t *player, const game_state_t *view,
+						pthread_mutex_t *view_lock, position_t *move) {
+	pthread_once(&g_pool_once, pool_init);
+	if (g_pool.workers == 0 || pthread_mutex_trylock(&g_pool.caller_lock) != 0) {
+		return 0;
+	}
+	start_deadline(player);
+
+	pthread_mutex_lock(view_lock);
+	memcpy(g_pool.root->board, view->board, sizeof(g_pool.root->board));
+	pthread_mutex_unlock(view_lock);
+
+	int found = search_root(player, move);
+	pthread_mutex_unlock(&g_pool.caller_lock);
+	return found;
+}
@@ -2,15 +2,18 @@
 
 static player_t g_player;
 static int g_display_mode = 0;
+static int g_threads = 0;
+static int g_ai_budget = 0;
+static int g_tick_usec = 500000;
+static const char *g_restore_path = NULL;
+
+static volatile sig_atomic_t g_signal = 0;
 
 void signal_handler(int sig) {
-	// Handle signals for clean exit
-	printf("\nReceived signal %d, cleaning up...\n", sig);
-	if (g_player.game_state != NULL) {
-		remove_player(&g_player);
-		cleanup_ipc(&g_player);
-	}
-	exit(0);
+	// The signal may land while we hold SEM_BOARD, so only stop the game
+	// loop and leave the board on the normal exit path
+	g_signal = sig;
+	request_player_stop();
 }
 
 void setup_signal_handlers(void) {
@@ -26,28 +29,94 @@ void display_usage(void) {
 	printf("\033[1m╚══════════════════════════════════╝\033[0m\n\n");
 	
 	printf("\033[1mUSAGE:\033[0m\n");
-	printf("  ./lemipc <team_number> [options]\n\n");
+	printf("  ./lemipc <team_number> [options]\n");
+	printf("  ./lemipc --export <socket_path> [interval_ms]\n");
+	printf("  ./lemipc --checkpoint <file>\n\n");
 	
 	printf("\033[1mARGUMENTS:\033[0m\n");
 	printf("  team_number    Team number (1-4)\n\n");
 	
 	printf("\033[1mOPTIONS:\033[0m\n");
-	printf("  -d, --display  Enable real-time board display\n");
-	printf("  -h, --help     Show this help message\n");
-	printf("  -v, --version  Show version information\n\n");
+	printf("  -d, --display      Enable real-time board display\n");
+	printf("  -t, --threads <n>  Host n players of the team as threads\n");
+	printf("  -b, --budget <us>  Search moves ahead within this time budget\n");
+	printf("  -i, --tick <usec>  Player tick interval (default 500000)\n");
+	printf("  -R, --restore <f>  Start the arena from a checkpoint file\n");
+	printf("  --export <path>    Stream board deltas to a Unix socket\n");
+	printf("  --checkpoint <f>   Save the running arena to a file\n");
+	printf("  -h, --help         Show this help message\n");
+	printf("  -v, --version      Show version information\n\n");
 	
 	printf("\033[1mEXAMPLES:\033[0m\n");
 	printf("  ./lemipc 1              # Join team 1\n");
 	printf("  ./lemipc 2 -d           # Join team 2 with display\n");
-	printf("  ./lemipc 3 --display    # Join team 3 with display\n\n");
+	printf("  ./lemipc 3 --display    # Join team 3 with display\n");
+	printf("  ./lemipc 4 -t 10        # Host all of team 4 in one process\n");
+	printf("  ./lemipc 1 -b 2000      # Plan with a 2ms lookahead\n");
+	printf("  ./lemipc --export /tmp/lemipc.sock  # Feed local dashboards\n");
+	printf("  ./lemipc --checkpoint arena.ckpt    # Save the game...\n");
+	printf("  ./lemipc 1 -R arena.ckpt            # ...and rejoin it later\n\n");
 	
 	printf("\033[1mGAME RULES:\033[0m\n");
-	printf("  • Players battle on a 10x10 board\n");
+	printf("  • Players battle on a %dx%d board\n", BOARD_SIZE, BOARD_SIZE);
 	printf("  • Goal: Be the last team standing\n");
 	printf("  • Killed when surrounded by ≥2 enemies\n");
 	printf("  • Teams: \033[31m1(Red)\033[0m \033[32m2(Green)\033[0m \033[33m3(Yellow)\033[0m \033[34m4(Blue)\033[0m\n\n");
 }
 
+// Observer mode: attach to the running arena and stream it
+static int run_export(int argc, char **argv) {
+	player_t observer;
+	int interval_ms = 100;
+	
+	if (argc < 3) {
+		display_usage();
+		return 1;
+	}
+	if (argc > 3) {
+		interval_ms = atoi(argv[3]);
+		if (interval_ms < 1) {
+			printf("Error: Interval must be at least 1 ms\n");
+			return 1;
+		}
+	}
+	
+	memset(&observer, 0, sizeof(player_t));
+	if (attach_ipc(&observer) == -1) {
+		printf("Error: Could not attach to a running arena\n");
+		return 1;
+	}
+	
+	printf("Streaming board to %s every %d ms\n", argv[2], interval_ms);
+	int result = export_board(&observer, argv[2], interval_ms);
+	shmdt(observer.game_state);
+	return result == 0 ? 0 : 1;
+}
+
+// Save the running arena without joining it
+static int run_checkpoint(int argc, char **argv) {
+	player_t observer;
+	
+	if (argc < 3) {
+		display_usage();
+		return 1;
+	}
+	
+	memset(&observer, 0, sizeof(player_t));
+	if (attach_ipc(&observer) == -1) {
+		printf("Error: Could not attach to a running arena\n");
+		return 1;
+	}
+	
+	int result = checkpoint_arena(&observer, argv[2]);
+	shmdt(observer.game_state);
+	if (result == -1) {
+		printf("Error: Could not write checkpoint %s\n", argv[2]);
+		return 1;
+	}
+	printf("Arena saved to %s\n", argv[2]);
+	return 0;
+}
 
 int main(int argc, char **argv) {
 	if (argc < 2) {
@@ -68,6 +137,13 @@ int main(int argc, char **argv) {
 		}
 	}
 	
+	if (strcmp(argv[1], "--export") == 0) {
+		return run_export(argc, argv);
+	}
+	if (strcmp(argv[1], "--checkpoint") == 0) {
+		return run_checkpoint(argc, argv);
+	}
+	
 	int team = atoi(argv[1]);
 	if (team < 1 || team > MAX_TEAMS) {
 		printf("Error: Team number must be between 1 and %d\n", MAX_TEAMS);
@@ -77,6 +153,26 @@ int main(int argc, char **argv) {
 	for (i = 2; i < argc; i++) {
 		if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--display") == 0) {
 			g_display_mode = 1;
+		} else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+			g_threads = atoi(argv[++i]);
+			if (g_threads < 1 || g_threads > MAX_PLAYERS_PER_TEAM) {
+				printf("Error: Thread count must be between 1 and %d\n", MAX_PLAYERS_PER_TEAM);
+				return 1;
+			}
+		} else if ((strcmp(argv[i], "-R") == 0 || strcmp(argv[i], "--restore") == 0) && i + 1 < argc) {
+			g_restore_path = argv[++i];
+		} else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--tick") == 0) && i + 1 < argc) {
+			g_tick_usec = atoi(argv[++i]);
+			if (g_tick_usec < 0) {
+				printf("Error: Tick interval must be positive\n");
+				return 1;
+			}
+		} else if ((strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--budget") == 0) && i + 1 < argc) {
+			g_ai_budget = atoi(argv[++i]);
+			if (g_ai_budget < 0) {
+				printf("Error: Time budget must be positive\n");
+				return 1;
+			}
 		} else {
 			printf("Unknown option: %s\n", argv[i]);
 			display_usage();
@@ -89,7 +185,10 @@ int main(int argc, char **argv) {
 	// Initialize player structure
 	memset(&g_player, 0, sizeof(player_t));
 	g_player.team = team;
-	g_player.player_id = getpid() % (MAX_TEAMS * MAX_PLAYERS_PER_TEAM);
+	g_player.player_id = getpid() % MAX_PLAYERS;
+	g_player.tick_usec = g_tick_usec;
+	g_player.ai_budget_usec = g_ai_budget;
+	g_player.restore_path = g_restore_path;
 	
 	setup_signal_handlers();
 	
@@ -97,6 +196,22 @@ int main(int argc, char **argv) {
 	
 	init_ipc(&g_player);
 	
+	if (g_player.game_state->lockstep.enabled || arbiter_running(g_player.game_state)) {
+		printf("Error: This arena runs in %s mode, join it with lemipc-swarm\n",
+			   g_player.game_state->lockstep.enabled ? "lockstep" : "arbiter");
+		cleanup_ipc(&g_player);
+		return 1;
+	}
+	
+	if (g_threads > 0) {
+		int placed = team_host_run(&g_player, g_threads, g_display_mode);
+		if (placed <= 0) {
+			printf("Error: Could not place team %d on board (board full?)\n", g_player.team);
+		}
+		cleanup_ipc(&g_player);
+		return placed > 0 ? 0 : 1;
+	}
+	
 	if (place_player(&g_player) == -1) {
 		printf("Error: Could not place player on board (board full?)\n");
 		cleanup_ipc(&g_player);
@@ -107,8 +222,17 @@ int main(int argc, char **argv) {
 		   g_player.player_id, g_player.pos.x, g_player.pos.y);
 
 	// Run game loop with or without display
-	player_game_loop(&g_player, g_display_mode);
+	int killed = player_game_loop(&g_player, g_display_mode);
+
+	if (g_signal) {
+		printf("\nReceived signal %d, cleaning up...\n", (int)g_signal);
+	}
 
+	// Leave the board even after a game over, so the last player out removes
+	// the arena
+	if (!killed) {
+		remove_player(&g_player);
+	}
 	cleanup_ipc(&g_player);
 	return 0;
 }
\ No newline at end of file
@@ -1,51 +1,55 @@
 #include "game.h"
 
-static const int KILL_DX[] = {-1, -1, -1,  0,  0,  1,  1,  1};
-static const int KILL_DY[] = {-1,  0,  1, -1,  1, -1,  0,  1};
-static const int KILL_DIRECTIONS = 8;
+// Neighbour offsets into the wall-bordered board, in the same order as the
+// (dx, dy) pairs they replace. BOARD_STRIDE is a compile-time constant, so
+// every board width gets its own constant tables.
+static const int KILL_OFFSETS[] = {
+	-BOARD_STRIDE - 1, -BOARD_STRIDE, -BOARD_STRIDE + 1,
+	-1,                                1,
+	 BOARD_STRIDE - 1,  BOARD_STRIDE,  BOARD_STRIDE + 1
+};
+#define KILL_DIRECTIONS 8
 
 static const int MOVE_DX[] = {-1,  0,  0,  1};
 static const int MOVE_DY[] = { 0, -1,  1,  0};
-static const int MOVE_DIRECTIONS = 4;
+static const int MOVE_OFFSETS[] = {-BOARD_STRIDE, -1, 1, BOARD_STRIDE};
+#define MOVE_DIRECTIONS 4
 
-static int count_adjacent_enemies(player_t *player, int x, int y) {
-	int enemy_count = 0;
-	int i;
+static const int *cell_at(game_state_t *game_state, int x, int y) {
+	return &game_state->board[0][0] + CELL_INDEX(x, y);
+}
+
+// Returns 2 when two cells of the same enemy team touch (x, y), 0 otherwise.
+// (x, y) must be on the board; its neighbours may be walls.
+int count_adjacent_enemies(game_state_t *game_state, int team, int x, int y) {
+	const int *cell = cell_at(game_state, x, y);
+	int neighbours[KILL_DIRECTIONS];
+	int i, j;
 
+#pragma GCC unroll 8
 	for (i = 0; i < KILL_DIRECTIONS; i++) {
-		int nx = x + KILL_DX[i];
-		int ny = y + KILL_DY[i];
+		neighbours[i] = cell[KILL_OFFSETS[i]];
+	}
 
-		if (nx >= 0 && nx < BOARD_SIZE && ny >= 0 && ny < BOARD_SIZE) {
-			int cell_team = player->game_state->board[nx][ny];
-			if (cell_team != EMPTY_CELL && cell_team != player->team) {
-				int same_enemy_team = 0;
-				int j;
-				for (j = 0; j < KILL_DIRECTIONS; j++) {
-					int nnx = x + KILL_DX[j];
-					int nny = y + KILL_DY[j];
-					if (j != i && nnx >= 0 && nnx < BOARD_SIZE &&
-						nny >= 0 && nny < BOARD_SIZE &&
-						player->game_state->board[nnx][nny] == cell_team) {
-						same_enemy_team = 1;
-						break;
-					}
-				}
-				if (same_enemy_team) {
-					enemy_count = 2;
-					break;
+	// Walls are negative and empty cells zero, only teams are > EMPTY_CELL
+	for (i = 0; i < KILL_DIRECTIONS - 1; i++) {
+		if (neighbours[i] > EMPTY_CELL && neighbours[i] != team) {
+			for (j = i + 1; j < KILL_DIRECTIONS; j++) {
+				if (neighbours[j] == neighbours[i]) {
+					return 2;
 				}
 			}
 		}
 	}
 
-	return enemy_count;
+	return 0;
 }
 
 int check_kill_condition(player_t *player) {
 	sem_lock(player->sem_id, SEM_BOARD);
 
-	int adjacent_enemies = count_adjacent_enemies(player, player->pos.x, player->pos.y);
+	int adjacent_enemies = count_adjacent_enemies(player->game_state, player->team,
+												  player->pos.x, player->pos.y);
 
 	sem_unlock(player->sem_id, SEM_BOARD);
 
@@ -92,7 +96,7 @@ static position_t find_nearest_enemy(player_t *player, int *enemy_team) {
 
 	for (i = 0; i < BOARD_SIZE; i++) {
 		for (j = 0; j < BOARD_SIZE; j++) {
-			int cell_team = player->game_state->board[i][j];
+			int cell_team = BOARD_CELL(player->game_state, i, j);
 			if (cell_team != EMPTY_CELL && cell_team != player->team) {
 				// Manhattan distance
 				int dist = abs(i - player->pos.x) + abs(j - player->pos.y);
@@ -114,13 +118,17 @@ static int count_nearby_teammates(player_t *player, int x, int y, int radius) {
 	int count = 0;
 	int i, j;
 
-	for (i = x - radius; i <= x + radius; i++) {
-		for (j = y - radius; j <= y + radius; j++) {
-			if (i >= 0 && i < BOARD_SIZE && j >= 0 && j < BOARD_SIZE) {
-				if (player->game_state->board[i][j] == player->team &&
-					!(i == player->pos.x && j == player->pos.y)) {
-					count++;
-				}
+	// Clamp the window once instead of testing every cell
+	int min_i = x - radius < 0 ? 0 : x - radius;
+	int max_i = x + radius >= BOARD_SIZE ? BOARD_SIZE - 1 : x + radius;
+	int min_j = y - radius < 0 ? 0 : y - radius;
+	int max_j = y + radius >= BOARD_SIZE ? BOARD_SIZE - 1 : y + radius;
+
+	for (i = min_i; i <= max_i; i++) {
+		for (j = min_j; j <= max_j; j++) {
+			if (BOARD_CELL(player->game_state, i, j) == player->team &&
+				!(i == player->pos.x && j == player->pos.y)) {
+				count++;
 			}
 		}
 	}
@@ -130,7 +138,7 @@ static int count_nearby_teammates(player_t *player, int x, int y, int radius) {
 
 // Check if moving to position is safe (won't get killed)
 static int is_safe_move(player_t *player, int x, int y) {
-	return count_adjacent_enemies(player, x, y) < 2;
+	return count_adjacent_enemies(player->game_state, player->team, x, y) < 2;
 }
 
 // Calculate next move toward target position
@@ -139,15 +147,15 @@ static position_t get_move_toward_target(player_t *player, position_t target) {
 	best_move.x = -1;
 	best_move.y = -1;
 	int min_distance = BOARD_SIZE * BOARD_SIZE + 1;
+	const int *origin = cell_at(player->game_state, player->pos.x, player->pos.y);
 	int i;
 
-	// Try all 4 valid directions
+	// Try all 4 valid directions, walls are never empty
 	for (i = 0; i < MOVE_DIRECTIONS; i++) {
 		int nx = player->pos.x + MOVE_DX[i];
 		int ny = player->pos.y + MOVE_DY[i];
 
-		if (nx >= 0 && nx < BOARD_SIZE && ny >= 0 && ny < BOARD_SIZE &&
-			player->game_state->board[nx][ny] == EMPTY_CELL) {
+		if (origin[MOVE_OFFSETS[i]] == EMPTY_CELL) {
 
 			// Calculate distance to target
 			int dist = abs(nx - target.x) + abs(ny - target.y);
@@ -168,8 +176,7 @@ static position_t get_move_toward_target(player_t *player, position_t target) {
 			int nx = player->pos.x + MOVE_DX[i];
 			int ny = player->pos.y + MOVE_DY[i];
 
-			if (nx >= 0 && nx < BOARD_SIZE && ny >= 0 && ny < BOARD_SIZE &&
-				player->game_state->board[nx][ny] == EMPTY_CELL) {
+			if (origin[MOVE_OFFSETS[i]] == EMPTY_CELL) {
 				int dist = abs(nx - target.x) + abs(ny - target.y);
 				if (dist < min_distance) {
 					min_distance = dist;
@@ -183,18 +190,67 @@ static position_t get_move_toward_target(player_t *player, position_t target) {
 	return best_move;
 }
 
+// Random move using ONLY 4 directions, preferring safe cells. A NULL seed
+// draws from rand(), otherwise from the caller's private rand_r() stream.
+static position_t get_random_move(player_t *player, unsigned int *seed) {
+	position_t moves[MOVE_DIRECTIONS];
+	const int *origin = cell_at(player->game_state, player->pos.x, player->pos.y);
+	int valid_moves = 0;
+	int i;
+
+	for (i = 0; i < MOVE_DIRECTIONS; i++) {
+		int nx = player->pos.x + MOVE_DX[i];
+		int ny = player->pos.y + MOVE_DY[i];
+
+		if (origin[MOVE_OFFSETS[i]] == EMPTY_CELL &&
+			is_safe_move(player, nx, ny)) {
+			moves[valid_moves].x = nx;
+			moves[valid_moves].y = ny;
+			valid_moves++;
+		}
+	}
+
+	position_t result;
+	if (valid_moves > 0) {
+		int choice = (seed ? rand_r(seed) : rand()) % valid_moves;
+		result = moves[choice];
+	} else {
+		// No safe moves - try any move
+		for (i = 0; i < MOVE_DIRECTIONS; i++) {
+			int nx = player->pos.x + MOVE_DX[i];
+			int ny = player->pos.y + MOVE_DY[i];
+
+			if (origin[MOVE_OFFSETS[i]] == EMPTY_CELL) {
+				result.x = nx;
+				result.y = ny;
+				return result;
+			}
+		}
+		// Completely stuck
+		result.x = -1;
+		result.y = -1;
+	}
+
+	return result;
+}
+
 // Intelligent move using team coordination via MSGQ
 static position_t get_intelligent_move(player_t *player) {
 	position_t target;
 	int target_team = 0;
 
+	// Search ahead when given a time budget and there is a fight nearby
+	if (player->ai_budget_usec > 0 && lookahead_move(player, &target)) {
+		return target;
+	}
+
 	// Check for team-coordinated targets via message queue
 	if (receive_target_message(player, &target, &target_team)) {
 		// Validate target still exists on board
 		sem_lock(player->sem_id, SEM_BOARD);
 		int target_still_there = (target.x >= 0 && target.x < BOARD_SIZE &&
 								  target.y >= 0 && target.y < BOARD_SIZE &&
-								  player->game_state->board[target.x][target.y] == target_team);
+								  BOARD_CELL(player->game_state, target.x, target.y) == target_team);
 		sem_unlock(player->sem_id, SEM_BOARD);
 
 		if (target_still_there) {
@@ -223,86 +279,120 @@ static position_t get_intelligent_move(player_t *player) {
 	}
 	sem_unlock(player->sem_id, SEM_BOARD);
 
-	// No enemies found - make safe random move using ONLY 4 directions
-	position_t moves[MOVE_DIRECTIONS];
-	int valid_moves = 0;
-	int i;
+	return get_random_move(player, NULL);
+}
 
-	for (i = 0; i < MOVE_DIRECTIONS; i++) {
-		int nx = player->pos.x + MOVE_DX[i];
-		int ny = player->pos.y + MOVE_DY[i];
+// Plan a move from the board as it is, without locking or touching the
+// message queue. Used when the board is known to be frozen (lockstep).
+position_t plan_move(player_t *player, unsigned int *seed) {
+	int enemy_team = 0;
+	position_t target = find_nearest_enemy(player, &enemy_team);
 
-		if (nx >= 0 && nx < BOARD_SIZE && ny >= 0 && ny < BOARD_SIZE &&
-			player->game_state->board[nx][ny] == EMPTY_CELL &&
-			is_safe_move(player, nx, ny)) {
-			moves[valid_moves].x = nx;
-			moves[valid_moves].y = ny;
-			valid_moves++;
-		}
+	if (target.x != -1) {
+		return get_move_toward_target(player, target);
 	}
+	return get_random_move(player, seed);
+}
 
-	position_t result;
-	if (valid_moves > 0) {
-		int choice = rand() % valid_moves;
-		result = moves[choice];
-	} else {
-		// No safe moves - try any move
-		for (i = 0; i < MOVE_DIRECTIONS; i++) {
-			int nx = player->pos.x + MOVE_DX[i];
-			int ny = player->pos.y + MOVE_DY[i];
+// Plan toward a target shared by the caller's team when it is still on the
+// board, otherwise pick the nearest enemy and publish it as the new target
+position_t plan_shared_move(player_t *player, position_t *target, int *target_team,
+							unsigned int *seed) {
+	if (*target_team != 0 && target->x >= 0 && target->x < BOARD_SIZE &&
+		target->y >= 0 && target->y < BOARD_SIZE &&
+		BOARD_CELL(player->game_state, target->x, target->y) == *target_team) {
+		return get_move_toward_target(player, *target);
+	}
 
-			if (nx >= 0 && nx < BOARD_SIZE && ny >= 0 && ny < BOARD_SIZE &&
-				player->game_state->board[nx][ny] == EMPTY_CELL) {
-				result.x = nx;
-				result.y = ny;
-				return result;
-			}
-		}
-		// Completely stuck
-		result.x = -1;
-		result.y = -1;
+	*target_team = 0;
+	*target = find_nearest_enemy(player, target_team);
+	if (target->x != -1) {
+		return get_move_toward_target(player, *target);
 	}
+	return get_random_move(player, seed);
+}
 
-	return result;
+static position_t plan_intelligent_move(player_t *player, void *context) {
+	(void)context;
+	// Use intelligent movement with MSGQ coordination
+	return get_intelligent_move(player);
 }
 
-void player_game_loop(player_t *player, int display_mode) {
+static volatile sig_atomic_t g_stop_requested = 0;
+
+// Make every player loop of this process return at its next tick. Only
+// sets a flag, so it may be called from a signal handler.
+void request_player_stop(void) {
+	g_stop_requested = 1;
+}
+
+int player_stop_requested(void) {
+	return g_stop_requested;
+}
+
+// Run one player until it dies, the game ends or request_player_stop() is
+// called, asking `planner` for every move. Returns 1 if the player was
+// eliminated.
+int run_player_loop(player_t *player, int display_mode, move_planner_t planner, void *context) {
 	int move_counter = 0;
 	int killed = 0;
 
-	while (!player->game_state->game_over && !killed) {
+	while (!player->game_state->game_over && !killed && !g_stop_requested) {
+		// Sample before checking flags so a referee wake-up is never lost
+		unsigned int notify_seq = __atomic_load_n(&player->game_state->notify_seq,
+												  __ATOMIC_ACQUIRE);
+		int refereed = referee_running(player->game_state);
+
 		// Display board periodically if display mode is enabled
 		if (display_mode && (move_counter % 2 == 0)) {
 			display_board(player->game_state, player->sem_id);
 		}
 
-		if (check_kill_condition(player)) {
+		// A referee already took us off the board and counted the kill. It
+		// may have stopped since, so check whatever the referee state.
+		if (player->game_state->eliminated[player->player_id]) {
+			printf("💀 Player %d from team %d has been eliminated!\n",
+				   player->player_id, player->team);
+			killed = 1;
+			break;
+		}
+		if (!refereed && check_kill_condition(player)) {
 			sem_lock(player->sem_id, SEM_BOARD);
-			player->game_state->total_kills++;
+			// A last sweep may have beaten us to it
+			if (!player->game_state->eliminated[player->player_id]) {
+				player->game_state->total_kills++;
+				clear_player_slot(player->game_state, player->player_id, player->pos,
+								  player->team);
+			}
 			sem_unlock(player->sem_id, SEM_BOARD);
 
 			printf("💀 Player %d from team %d has been eliminated!\n",
 				   player->player_id, player->team);
-			remove_player(player);
 			killed = 1;
 			break;
 		}
 
-		if (is_game_over(player->game_state)) {
+		if (!refereed && is_game_over(player->game_state)) {
 			player->game_state->game_over = 1;
 			break;
 		}
 
+		if (player->game_state->orphans_expire_at != 0 &&
+			time(NULL) >= player->game_state->orphans_expire_at) {
+			sem_lock(player->sem_id, SEM_BOARD);
+			expire_orphans(player->game_state);
+			sem_unlock(player->sem_id, SEM_BOARD);
+		}
+
 		move_counter++;
 		if (move_counter % 5 == 0) {
-			// Use intelligent movement with MSGQ coordination
-			position_t new_pos = get_intelligent_move(player);
+			position_t new_pos = planner(player, context);
 			if (new_pos.x != -1) {
 				move_player(player, new_pos.x, new_pos.y);
 			}
 		}
 
-		usleep(500000);
+		arena_wait(player->game_state, notify_seq, player->tick_usec);
 	}
 
 	// Display final board state if display mode is enabled
@@ -314,4 +404,9 @@ void player_game_loop(player_t *player, int display_mode) {
 		printf("Game over! Player %d from team %d exiting.\n",
 			   player->player_id, player->team);
 	}
+	return killed;
+}
+
+int player_game_loop(player_t *player, int display_mode) {
+	return run_player_loop(player, display_mode, plan_intelligent_move, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "game.h"
+
+// The referee takes global work off the players: it sweeps the whole board
+// for surrounded players once per period, flags victims in eliminated[] and
+// owns the game_over decision. Every change is followed by a futex wake-up,
+// so sleeping players notice a kill or the end of the game right away.
+
+static volatile sig_atomic_t g_referee_stop = 0;
+
+static void referee_signal_handler(int sig) {
+	(void)sig;
+	g_referee_stop = 1;
+}
+
+void referee_loop(player_t *arena) {
+	game_state_t *game_state = arena->game_state;
+	long sweeps = 0;
+	long kills = 0;
+
+	signal(SIGINT, referee_signal_handler);
+	signal(SIGTERM, referee_signal_handler);
+	signal(SIGQUIT, referee_signal_handler);
+
+	while (!g_referee_stop && !game_state->game_over) {
+		usleep(arena->tick_usec);
+
+		sem_lock(arena->sem_id, SEM_BOARD);
+		game_state->referee_alive_until = SERVICE_DEADLINE(arena->tick_usec);
+		int swept = resolve_kills(game_state);
+		if (is_game_over(game_state)) {
+			game_state->game_over = 1;
+		}
+		int game_over = game_state->game_over;
+		sem_unlock(arena->sem_id, SEM_BOARD);
+
+		if (swept > 0 || game_over) {
+			arena_notify(game_state);
+		}
+		kills += swept;
+		sweeps++;
+	}
+
+	// Hand kill and game-over checks back to the players
+	sem_lock(arena->sem_id, SEM_BOARD);
+	game_state->referee_pid = 0;
+	sem_unlock(arena->sem_id, SEM_BOARD);
+	arena_notify(game_state);
+
+	printf("Referee: %ld sweeps, %ld kills\n", sweeps, kills);
+}
+
+// A referee killed with SIGKILL never clears referee_pid, so only trust the
+// pid while its heartbeat is recent. Called by every player on every tick:
+// time() is a vDSO call where kill(pid, 0) would be a syscall.
+int referee_running(game_state_t *game_state) {
+	return game_state->referee_pid != 0 && time(NULL) <= game_state->referee_alive_until;
+}
@@ -0,0 +1,486 @@
+#include "game.h"
+
+// Stress harness: fills the arena with free-running players at a high tick
+// rate, copies the shared state every few milliseconds and cross-checks it
+// with check_board_invariants. After each round it detaches without touching
+// the IPC objects and verifies that the last process out removed them all.
+// With --exec the players are real lemipc processes, which pick their slot
+// from getpid() like user-started players do. Rounds are repeated with the
+// players pinned to 1, 2, 4 ... N CPUs to report how throughput scales.
+
+#define STRESS_MAX_REPORTS 5
+#define STRESS_EXIT_TIMEOUT_MS 5000
+#define STRESS_LOCK_TIMEOUT_SEC 5
+
+typedef struct {
+	int per_team;
+	int teams;
+	int tick_usec;
+	int duration_sec;
+	int check_ms;
+	int referee;
+	int team_threads;
+	const char *exec_path;
+} stress_config_t;
+
+typedef struct {
+	int cpus;
+	int players;
+	double seconds;
+	long moves;
+	int kills;
+	int checks;
+	int violations;
+	int leaked;
+	int game_over;
+} stress_result_t;
+
+static pid_t g_pids[MAX_PLAYERS];
+static int g_spawned = 0;
+static pid_t g_referee = 0;
+static volatile sig_atomic_t g_stress_stop = 0;
+
+static void stop_signal_handler(int sig) {
+	(void)sig;
+	g_stress_stop = 1;
+}
+
+static double elapsed_sec(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void display_usage(void) {
+	printf("\033[1mUSAGE:\033[0m\n");
+	printf("  ./lemipc-stress <players_per_team> [options]\n\n");
+
+	printf("\033[1mARGUMENTS:\033[0m\n");
+	printf("  players_per_team   Players to spawn per team (1-%d)\n\n", MAX_PLAYERS_PER_TEAM);
+
+	printf("\033[1mOPTIONS:\033[0m\n");
+	printf("  -t, --teams <n>    Number of teams to fill (1-%d, default %d)\n", MAX_TEAMS, MAX_TEAMS);
+	printf("  -i, --tick <usec>  Player tick interval (default 1000)\n");
+	printf("  -d, --duration <s> Length of each round in seconds (default 5)\n");
+	printf("  -c, --cpus <n>     Largest CPU count to scale to (default: all online)\n");
+	printf("  -k, --check <ms>   Interval between invariant checks (default 20)\n");
+	printf("  -r, --referee      Sweep kills in a referee process\n");
+	printf("  -T, --team-threads Host each team in one process, one thread per player\n");
+	printf("  -x, --exec <path>  Run each player as a separate lemipc program\n");
+	printf("  -h, --help         Show this help message\n\n");
+
+	printf("\033[1mEXAMPLES:\033[0m\n");
+	printf("  ./lemipc-stress 10                  # Default arena, 1..N CPUs\n");
+	printf("  ./lemipc-stress 10 -i 100 -c 2 -r   # Faster ticks, refereed, up to 2 CPUs\n");
+	printf("  ./lemipc-stress 10 -x ./lemipc      # Real lemipc processes\n");
+	printf("  make re BOARD_SIZE=40 PLAYERS_PER_TEAM=100 && ./lemipc-stress 100\n\n");
+}
+
+// Reap `count` children that were asked to exit. Whatever is still running
+// after STRESS_EXIT_TIMEOUT_MS gets SIGKILL, so a stuck process cannot hang
+// the harness. Returns how many had to be killed.
+static int reap_children(pid_t *pids, int count) {
+	struct timespec start;
+	int remaining, killed = 0;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		remaining = 0;
+		for (i = 0; i < count; i++) {
+			if (pids[i] <= 0) {
+				continue;
+			}
+			pid_t reaped = waitpid(pids[i], NULL, WNOHANG);
+			if (reaped == pids[i] || (reaped == -1 && errno != EINTR)) {
+				pids[i] = 0;
+			} else {
+				remaining++;
+			}
+		}
+		if (remaining == 0) {
+			return 0;
+		}
+		usleep(10000);
+	} while (elapsed_sec(&start) * 1000 < STRESS_EXIT_TIMEOUT_MS);
+
+	for (i = 0; i < count; i++) {
+		if (pids[i] > 0) {
+			kill(pids[i], SIGKILL);
+			while (waitpid(pids[i], NULL, 0) == -1 && errno == EINTR) {
+			}
+			pids[i] = 0;
+			killed++;
+		}
+	}
+	return killed;
+}
+
+// Stop every process of the round and wait for them to exit. The referee
+// goes first so it never outlives the semaphore set. Returns the number of
+// processes that did not exit in time and were killed.
+static int stop_round(void) {
+	int stuck = 0;
+	int i;
+
+	if (g_referee > 0) {
+		kill(g_referee, SIGTERM);
+		stuck += reap_children(&g_referee, 1);
+	}
+
+	for (i = 0; i < g_spawned; i++) {
+		if (g_pids[i] > 0) {
+			kill(g_pids[i], SIGTERM);
+		}
+	}
+	stuck += reap_children(g_pids, g_spawned);
+	g_spawned = 0;
+	return stuck;
+}
+
+// Remove whatever a round left behind so the next one starts clean
+static void remove_leftover_ipc(void) {
+	int shm_id = shmget(SHM_KEY, 0, 0);
+	int msg_id = msgget(MSG_KEY, 0);
+	int sem_id = semget(SEM_KEY, 0, 0);
+
+	if (shm_id != -1) {
+		shmctl(shm_id, IPC_RMID, NULL);
+	}
+	if (msg_id != -1) {
+		msgctl(msg_id, IPC_RMID, NULL);
+	}
+	if (sem_id != -1) {
+		semctl(sem_id, 0, IPC_RMID);
+	}
+}
+
+// Copy the shared state under SEM_BOARD. Returns -1 once the semaphore set is
+// gone, which happens when the last player left and removed the arena, and
+// -2 if the lock stayed held for STRESS_LOCK_TIMEOUT_SEC.
+static int snapshot_arena(player_t *arena, game_state_t *snapshot) {
+	struct sembuf lock = {SEM_BOARD, -1, 0};
+	struct sembuf unlock = {SEM_BOARD, 1, 0};
+	struct timespec timeout = {STRESS_LOCK_TIMEOUT_SEC, 0};
+
+	while (semtimedop(arena->sem_id, &lock, 1, &timeout) == -1) {
+		if (errno == EAGAIN) {
+			return -2;
+		}
+		if (errno != EINTR) {
+			return -1;
+		}
+	}
+	memcpy(snapshot, arena->game_state, sizeof(game_state_t));
+	semop(arena->sem_id, &unlock, 1);
+	return 0;
+}
+
+// Exec `lemipc <team> -i <tick>`, hosting `threads` players with -t if set
+static pid_t spawn_lemipc(const stress_config_t *config, int team, int threads, int cpu) {
+	char team_arg[16], tick_arg[16], threads_arg[16];
+	char *argv[8];
+	int argc = 0;
+
+	snprintf(team_arg, sizeof(team_arg), "%d", team);
+	snprintf(tick_arg, sizeof(tick_arg), "%d", config->tick_usec);
+	argv[argc++] = (char *)config->exec_path;
+	argv[argc++] = team_arg;
+	argv[argc++] = "-i";
+	argv[argc++] = tick_arg;
+	if (threads > 0) {
+		snprintf(threads_arg, sizeof(threads_arg), "%d", threads);
+		argv[argc++] = "-t";
+		argv[argc++] = threads_arg;
+	}
+	argv[argc] = NULL;
+	return spawn_program(argv, cpu);
+}
+
+static int spawn_round(const stress_config_t *config, player_t *arena, int cpus) {
+	int expected = 0;
+	int team, k;
+
+	for (team = 1; team <= config->teams; team++) {
+		if (config->exec_path != NULL) {
+			int processes = config->team_threads ? 1 : config->per_team;
+			for (k = 0; k < processes; k++) {
+				pid_t pid = spawn_lemipc(config, team, config->team_threads ? config->per_team : 0,
+										 g_spawned % cpus);
+				if (pid == -1) {
+					return expected;
+				}
+				g_pids[g_spawned++] = pid;
+				expected += config->team_threads ? config->per_team : 1;
+			}
+			continue;
+		}
+		if (config->team_threads) {
+			pid_t pid = spawn_team(arena, team, config->per_team, g_spawned % cpus);
+			if (pid == -1) {
+				return expected;
+			}
+			g_pids[g_spawned++] = pid;
+			expected += config->per_team;
+			continue;
+		}
+		for (k = 0; k < config->per_team; k++) {
+			player_t player = *arena;
+			player.team = team;
+			player.player_id = (team - 1) * MAX_PLAYERS_PER_TEAM + k;
+			pid_t pid = spawn_player(&player, g_spawned % cpus);
+			if (pid == -1) {
+				return expected;
+			}
+			g_pids[g_spawned++] = pid;
+			expected++;
+		}
+	}
+	return expected;
+}
+
+static int run_round(const stress_config_t *config, int cpus, stress_result_t *result) {
+	game_state_t *snapshot = malloc(sizeof(game_state_t));
+	char report[256];
+	int reported = 0;
+
+	if (snapshot == NULL) {
+		perror("malloc");
+		return -1;
+	}
+	memset(result, 0, sizeof(stress_result_t));
+	result->cpus = cpus;
+
+	player_t arena;
+	memset(&arena, 0, sizeof(player_t));
+	arena.tick_usec = config->tick_usec;
+	init_ipc(&arena);
+	game_state_t *game_state = arena.game_state;
+
+	if (config->referee) {
+		g_referee = spawn_service(&arena, referee_loop);
+		if (g_referee != -1) {
+			sem_lock(arena.sem_id, SEM_BOARD);
+			game_state->referee_pid = g_referee;
+			game_state->referee_alive_until = SERVICE_DEADLINE(config->tick_usec);
+			sem_unlock(arena.sem_id, SEM_BOARD);
+		}
+	}
+
+	int expected = spawn_round(config, &arena, cpus);
+	int joined = wait_for_players(&arena, expected, g_pids, g_spawned, 30000);
+	result->players = joined == -1 ? 0 : expected;
+
+	if (snapshot_arena(&arena, snapshot) != 0) {
+		memcpy(snapshot, game_state, sizeof(game_state_t));
+	}
+	long start_moves = snapshot->total_moves;
+	int start_kills = snapshot->total_kills;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	int last_joins = 0;
+	int last_kills = 0;
+	int was_over = 0;
+	while (joined != -1 && !g_stress_stop && elapsed_sec(&start) < config->duration_sec) {
+		usleep(config->check_ms * 1000);
+
+		int copied = snapshot_arena(&arena, snapshot);
+		if (copied == -2) {
+			result->violations++;
+			printf("  check %d: board lock held for over %ds\n", result->checks + 1,
+				   STRESS_LOCK_TIMEOUT_SEC);
+			break;
+		}
+		if (copied == -1) {
+			break;
+		}
+		result->checks++;
+
+		int found = check_board_invariants(snapshot, report, sizeof(report));
+		// Counters only ever grow, and a finished game stays finished
+		if (snapshot->total_joins < last_joins || snapshot->total_kills < last_kills ||
+			(was_over && !snapshot->game_over)) {
+			if (found++ == 0) {
+				snprintf(report, sizeof(report), "a counter or game_over went backwards");
+			}
+		}
+		last_joins = snapshot->total_joins;
+		last_kills = snapshot->total_kills;
+		was_over = snapshot->game_over;
+
+		if (found > 0) {
+			result->violations += found;
+			if (reported++ < STRESS_MAX_REPORTS) {
+				printf("  check %d: %d violation(s), first: %s\n", result->checks, found, report);
+			}
+		}
+		if (snapshot->game_over) {
+			break;
+		}
+	}
+
+	result->seconds = elapsed_sec(&start);
+	if (snapshot_arena(&arena, snapshot) != 0) {
+		memcpy(snapshot, game_state, sizeof(game_state_t));
+	}
+	result->moves = snapshot->total_moves - start_moves;
+	result->kills = snapshot->total_kills - start_kills;
+
+	int stuck = stop_round();
+	if (stuck > 0) {
+		result->violations++;
+		printf("  %d processes did not exit within %d ms, killed them\n", stuck,
+			   STRESS_EXIT_TIMEOUT_MS);
+	}
+
+	// Nobody else is attached any more, and the last player out may already
+	// have removed the semaphore set, so read the segment without locking
+	memcpy(snapshot, game_state, sizeof(game_state_t));
+	result->game_over = snapshot->game_over;
+	int found = check_board_invariants(snapshot, report, sizeof(report));
+	if (found == 0 && snapshot->player_count != 0) {
+		found = 1;
+		snprintf(report, sizeof(report), "%d players still counted after every process left",
+				 snapshot->player_count);
+	}
+	if (found > 0) {
+		result->violations += found;
+		printf("  after exit: %d violation(s), first: %s\n", found, report);
+	}
+
+	// Only detach: cleanup_ipc or destroy_ipc here would remove whatever the
+	// players left behind and hide the leak
+	shmdt(game_state);
+	if (arena_exists()) {
+		result->leaked = 1;
+		printf("  IPC objects left behind after the round, removing them\n");
+		remove_leftover_ipc();
+	}
+
+	free(snapshot);
+	return joined == -1 ? -1 : 0;
+}
+
+int main(int argc, char **argv) {
+	stress_config_t config;
+	stress_result_t results[64];
+	int result_count = 0;
+	int failed = 0;
+	int max_cpus;
+	int i;
+
+	if (argc < 2) {
+		display_usage();
+		return 1;
+	}
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+			display_usage();
+			return 0;
+		}
+	}
+
+	memset(&config, 0, sizeof(config));
+	config.per_team = atoi(argv[1]);
+	config.teams = MAX_TEAMS;
+	config.tick_usec = 1000;
+	config.duration_sec = 5;
+	config.check_ms = 20;
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	max_cpus = online > 0 ? (int)online : 1;
+
+	if (config.per_team < 1 || config.per_team > MAX_PLAYERS_PER_TEAM) {
+		printf("Error: Players per team must be between 1 and %d\n", MAX_PLAYERS_PER_TEAM);
+		return 1;
+	}
+
+	for (i = 2; i < argc; i++) {
+		if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--teams") == 0) && i + 1 < argc) {
+			config.teams = atoi(argv[++i]);
+		} else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--tick") == 0) && i + 1 < argc) {
+			config.tick_usec = atoi(argv[++i]);
+		} else if ((strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--duration") == 0) && i + 1 < argc) {
+			config.duration_sec = atoi(argv[++i]);
+		} else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--cpus") == 0) && i + 1 < argc) {
+			max_cpus = atoi(argv[++i]);
+		} else if ((strcmp(argv[i], "-k") == 0 || strcmp(argv[i], "--check") == 0) && i + 1 < argc) {
+			config.check_ms = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--referee") == 0) {
+			config.referee = 1;
+		} else if (strcmp(argv[i], "-T") == 0 || strcmp(argv[i], "--team-threads") == 0) {
+			config.team_threads = 1;
+		} else if ((strcmp(argv[i], "-x") == 0 || strcmp(argv[i], "--exec") == 0) && i + 1 < argc) {
+			config.exec_path = argv[++i];
+		} else {
+			printf("Unknown option: %s\n", argv[i]);
+			display_usage();
+			return 1;
+		}
+	}
+	if (config.teams < 1 || config.teams > MAX_TEAMS) {
+		printf("Error: Team count must be between 1 and %d\n", MAX_TEAMS);
+		return 1;
+	}
+	if (config.tick_usec < 0 || config.duration_sec < 1 || config.check_ms < 1) {
+		printf("Error: Tick, duration and check interval must be positive\n");
+		return 1;
+	}
+	if (max_cpus < 1 || max_cpus > online) {
+		printf("Error: CPU count must be between 1 and %ld\n", online);
+		return 1;
+	}
+	if (config.exec_path != NULL && access(config.exec_path, X_OK) == -1) {
+		printf("Error: Cannot run %s\n", config.exec_path);
+		return 1;
+	}
+	if (arena_exists()) {
+		printf("Error: An arena is already running, stop it before a stress run\n");
+		return 1;
+	}
+
+	swarm_quiet_players(1);
+	signal(SIGINT, stop_signal_handler);
+	signal(SIGTERM, stop_signal_handler);
+	signal(SIGQUIT, stop_signal_handler);
+
+	// 1, 2, 4 ... and always the largest count
+	int cpus = 1;
+	while (!g_stress_stop && result_count < 64) {
+		printf("Round %d: %d players, %d CPU(s), tick %d us\n", result_count + 1,
+			   config.per_team * config.teams, cpus, config.tick_usec);
+		fflush(stdout);
+
+		stress_result_t *result = &results[result_count++];
+		if (run_round(&config, cpus, result) == -1) {
+			printf("  arena did not fill within 30s\n");
+			failed = 1;
+		}
+		if (result->violations > 0 || result->leaked) {
+			failed = 1;
+		}
+
+		if (cpus == max_cpus) {
+			break;
+		}
+		cpus = cpus * 2 > max_cpus ? max_cpus : cpus * 2;
+	}
+
+	printf("\n%6s %8s %8s %12s %8s %7s %7s %11s %6s\n", "CPUs", "Players", "Seconds",
+		   "Moves/s", "Speedup", "Kills", "Checks", "Violations", "Leaks");
+	double base = 0;
+	for (i = 0; i < result_count; i++) {
+		stress_result_t *r = &results[i];
+		double rate = r->seconds > 0 ? r->moves / r->seconds : 0;
+		if (i == 0) {
+			base = rate;
+		}
+		printf("%6d %8d %8.2f %12.0f %7.2fx %7d %7d %11d %6s%s\n", r->cpus, r->players,
+			   r->seconds, rate, base > 0 ? rate / base : 0.0, r->kills, r->checks,
+			   r->violations, r->leaked ? "yes" : "no", r->game_over ? "  (game over)" : "");
+	}
+
+	printf("\n%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
@@ -0,0 +1,221 @@
+#include "game.h"
+
+static player_t g_swarm_player;
+static int g_quiet_players = 0;
+
+// The signal may land while this process holds SEM_BOARD, so only ask the
+// loop to stop; spawn_player leaves the board on its way out
+static void swarm_signal_handler(int sig) {
+	(void)sig;
+	request_player_stop();
+}
+
+static void pin_to_cpu(int cpu) {
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+		perror("sched_setaffinity");
+	}
+}
+
+static sigset_t g_saved_mask;
+
+// fork() with the launcher's signals held, so the child can never run a
+// handler meant for the launcher. In the child every handler is back to
+// SIG_DFL and the signals stay held until release_signals().
+static void hold_signals(sigset_t *saved) {
+	sigset_t held;
+
+	sigemptyset(&held);
+	sigaddset(&held, SIGINT);
+	sigaddset(&held, SIGTERM);
+	sigaddset(&held, SIGQUIT);
+	sigprocmask(SIG_BLOCK, &held, saved);
+}
+
+static pid_t fork_child(void) {
+	hold_signals(&g_saved_mask);
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+		signal(SIGQUIT, SIG_DFL);
+		return 0;
+	}
+
+	sigprocmask(SIG_SETMASK, &g_saved_mask, NULL);
+	if (pid == -1) {
+		perror("fork");
+	}
+	return pid;
+}
+
+static void release_signals(void) {
+	sigprocmask(SIG_SETMASK, &g_saved_mask, NULL);
+}
+
+static void silence_stdout(void) {
+	int null_fd = open("/dev/null", O_WRONLY);
+	if (null_fd != -1) {
+		dup2(null_fd, STDOUT_FILENO);
+		close(null_fd);
+	}
+}
+
+// Send the output of players and teams forked from now on to /dev/null, so
+// hundreds of kill lines do not bury the launcher's own report
+void swarm_quiet_players(int quiet) {
+	g_quiet_players = quiet;
+}
+
+// Fork a player that reuses the arena mapping of the launcher instead of
+// going through init_ipc again. Lockstep players are placed by the launcher
+// before the fork. Returns the child pid, or -1 on failure.
+pid_t spawn_player(const player_t *player, int cpu) {
+	pid_t pid = fork_child();
+	if (pid != 0) {
+		return pid;
+	}
+
+	g_swarm_player = *player;
+	if (g_quiet_players) {
+		silence_stdout();
+	}
+
+	signal(SIGINT, swarm_signal_handler);
+	signal(SIGTERM, swarm_signal_handler);
+	signal(SIGQUIT, swarm_signal_handler);
+	release_signals();
+
+	if (cpu >= 0) {
+		pin_to_cpu(cpu);
+	}
+	srand(time(NULL) + getpid());
+
+	int killed = 0;
+	// The arbiter clears its pid when it goes, leave the way we played
+	int arbitrated = g_swarm_player.game_state->arbiter_pid != 0;
+	if (g_swarm_player.game_state->lockstep.enabled) {
+		lockstep_game_loop(&g_swarm_player, 0);
+	} else {
+		if (place_player(&g_swarm_player) == -1) {
+			shmdt(g_swarm_player.game_state);
+			_exit(1);
+		}
+		if (arbitrated) {
+			arbiter_player_loop(&g_swarm_player);
+		} else {
+			killed = player_game_loop(&g_swarm_player, 0);
+		}
+	}
+
+	// Leave the board even after a game over, so the last player out
+	// removes the arena
+	if (g_swarm_player.game_state->lockstep.enabled) {
+		lockstep_leave(&g_swarm_player);
+	} else if (arbitrated) {
+		arbiter_leave(&g_swarm_player);
+	} else if (!killed) {
+		remove_player(&g_swarm_player);
+	}
+	cleanup_ipc(&g_swarm_player);
+	fflush(stdout);
+	_exit(0);
+}
+
+// Fork one process hosting a whole team as threads
+pid_t spawn_team(const player_t *arena, int team, int count, int cpu) {
+	pid_t pid = fork_child();
+	if (pid != 0) {
+		return pid;
+	}
+
+	release_signals();
+	if (g_quiet_players) {
+		silence_stdout();
+	}
+	player_t host = *arena;
+	host.team = team;
+	if (cpu >= 0) {
+		pin_to_cpu(cpu);
+	}
+	srand(time(NULL) + getpid());
+
+	int placed = team_host_run(&host, count, 0);
+	if (placed > 0) {
+		cleanup_ipc(&host);
+	} else {
+		shmdt(host.game_state);
+	}
+	fflush(stdout);
+	_exit(placed > 0 ? 0 : 1);
+}
+
+// Fork an arena service process (arbiter, referee) running `loop`
+pid_t spawn_service(const player_t *arena, void (*loop)(player_t *)) {
+	pid_t pid = fork_child();
+	if (pid != 0) {
+		return pid;
+	}
+
+	release_signals();
+	player_t service = *arena;
+	loop(&service);
+	shmdt(service.game_state);
+	fflush(stdout);
+	_exit(0);
+}
+
+// Fork and exec a separate program, such as a real lemipc player, which
+// joins the arena through init_ipc like any user-started process. Its
+// output goes to /dev/null so a full arena does not flood the launcher.
+pid_t spawn_program(char *const argv[], int cpu) {
+	pid_t pid = fork_child();
+	if (pid != 0) {
+		return pid;
+	}
+
+	release_signals();
+	if (cpu >= 0) {
+		pin_to_cpu(cpu);
+	}
+	silence_stdout();
+	execv(argv[0], argv);
+	perror(argv[0]);
+	_exit(127);
+}
+
+// Poll the arena until `target` joins have been counted. Children that exit
+// early (placement failed) lower the target. Returns the join count, or -1
+// on timeout.
+int wait_for_players(player_t *arena, int target, pid_t *pids, int count, int timeout_ms) {
+	struct timespec start, now;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	now = start;
+	while ((now.tv_sec - start.tv_sec) * 1000 +
+		   (now.tv_nsec - start.tv_nsec) / 1000000 < timeout_ms) {
+		for (i = 0; i < count; i++) {
+			int status;
+			if (pids[i] > 0 && waitpid(pids[i], &status, WNOHANG) == pids[i]) {
+				pids[i] = 0;
+				target--;
+			}
+		}
+
+		// A single counter needs no lock, and the arena may already have been
+		// removed if the game ended while filling up
+		int joins = __atomic_load_n(&arena->game_state->total_joins, __ATOMIC_ACQUIRE);
+
+		if (joins >= target) {
+			return joins;
+		}
+		usleep(1000);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	}
+	return -1;
+}
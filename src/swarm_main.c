@@ -0,0 +1,295 @@
+#include "game.h"
+
+static pid_t g_pids[MAX_PLAYERS];
+static player_t g_fleet[MAX_PLAYERS];
+static int g_spawned = 0;
+static pid_t g_arbiter = 0;
+static pid_t g_referee = 0;
+
+static void forward_signal(int sig) {
+	int i;
+	(void)sig;
+	for (i = 0; i < g_spawned; i++) {
+		if (g_pids[i] > 0) {
+			kill(g_pids[i], SIGTERM);
+		}
+	}
+	if (g_arbiter > 0) {
+		kill(g_arbiter, SIGTERM);
+	}
+	if (g_referee > 0) {
+		kill(g_referee, SIGTERM);
+	}
+}
+
+static double elapsed_ms(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0 +
+		   (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void display_usage(void) {
+	printf("\033[1mUSAGE:\033[0m\n");
+	printf("  ./lemipc-swarm <players_per_team> [options]\n\n");
+
+	printf("\033[1mARGUMENTS:\033[0m\n");
+	printf("  players_per_team   Players to spawn per team (1-%d)\n\n", MAX_PLAYERS_PER_TEAM);
+
+	printf("\033[1mOPTIONS:\033[0m\n");
+	printf("  -t, --teams <n>    Number of teams to fill (1-%d, default %d)\n", MAX_TEAMS, MAX_TEAMS);
+	printf("  -i, --tick <usec>  Player tick interval (default 500000)\n");
+	printf("  -p, --pin          Pin players to CPUs round-robin\n");
+	printf("  -l, --lockstep     Run the arena in lockstep ticks\n");
+	printf("  -s, --seed <n>     Lockstep seed (default: current time)\n");
+	printf("  -a, --arbiter      Apply moves in batches from one arbiter process\n");
+	printf("  -r, --referee      Sweep kills and detect game over in a referee process\n");
+	printf("  -T, --team-threads Host each team in one process, one thread per player\n");
+	printf("  -b, --budget <us>  Lookahead time budget per move (default off)\n");
+	printf("  -h, --help         Show this help message\n\n");
+
+	printf("\033[1mEXAMPLES:\033[0m\n");
+	printf("  ./lemipc-swarm 10              # Fill every team\n");
+	printf("  ./lemipc-swarm 5 -t 2 -p       # Two pinned teams of 5\n");
+	printf("  ./lemipc-swarm 8 -l -s 42      # Replayable lockstep game\n");
+	printf("  ./lemipc-swarm 10 -a -i 10000  # Batched arbiter at 100 ticks/s\n");
+	printf("  ./lemipc-swarm 10 -r           # Refereed free-running game\n");
+	printf("  ./lemipc-swarm 10 -T -r        # Four processes, one per team\n\n");
+}
+
+int main(int argc, char **argv) {
+	int teams = MAX_TEAMS;
+	int tick_usec = 500000;
+	int pin = 0;
+	int lockstep = 0;
+	int arbiter = 0;
+	int referee = 0;
+	int team_threads = 0;
+	int ai_budget = 0;
+	unsigned int seed = time(NULL);
+	int i;
+
+	if (argc < 2) {
+		display_usage();
+		return 1;
+	}
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+			display_usage();
+			return 0;
+		}
+	}
+
+	int per_team = atoi(argv[1]);
+	if (per_team < 1 || per_team > MAX_PLAYERS_PER_TEAM) {
+		printf("Error: Players per team must be between 1 and %d\n", MAX_PLAYERS_PER_TEAM);
+		return 1;
+	}
+
+	for (i = 2; i < argc; i++) {
+		if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--teams") == 0) && i + 1 < argc) {
+			teams = atoi(argv[++i]);
+		} else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--tick") == 0) && i + 1 < argc) {
+			tick_usec = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--pin") == 0) {
+			pin = 1;
+		} else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--lockstep") == 0) {
+			lockstep = 1;
+		} else if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--seed") == 0) && i + 1 < argc) {
+			seed = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--arbiter") == 0) {
+			arbiter = 1;
+		} else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--referee") == 0) {
+			referee = 1;
+		} else if (strcmp(argv[i], "-T") == 0 || strcmp(argv[i], "--team-threads") == 0) {
+			team_threads = 1;
+		} else if ((strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--budget") == 0) && i + 1 < argc) {
+			ai_budget = atoi(argv[++i]);
+		} else {
+			printf("Unknown option: %s\n", argv[i]);
+			display_usage();
+			return 1;
+		}
+	}
+	if (teams < 1 || teams > MAX_TEAMS) {
+		printf("Error: Team count must be between 1 and %d\n", MAX_TEAMS);
+		return 1;
+	}
+	if (tick_usec < 0 || ai_budget < 0) {
+		printf("Error: Tick interval and time budget must be positive\n");
+		return 1;
+	}
+	if (lockstep + arbiter + referee > 1) {
+		printf("Error: Lockstep, arbiter and referee modes are exclusive\n");
+		return 1;
+	}
+	// Lockstep and arbiter players plan with plan_move only: a time-bounded
+	// search would break lockstep replays and outlast an arbiter batch
+	if (ai_budget > 0 && (lockstep || arbiter)) {
+		printf("Error: The lookahead budget only applies to free-running or refereed games\n");
+		return 1;
+	}
+	if (team_threads && (lockstep || arbiter)) {
+		printf("Error: Team threads only run free-running or refereed games\n");
+		return 1;
+	}
+
+	// Create (or attach to) the arena once; every player inherits the mapping
+	player_t arena;
+	memset(&arena, 0, sizeof(player_t));
+	arena.tick_usec = tick_usec;
+	arena.ai_budget_usec = ai_budget;
+	init_ipc(&arena);
+
+	sem_lock(arena.sem_id, SEM_BOARD);
+	int initial_players = arena.game_state->player_count;
+	int initial_joins = arena.game_state->total_joins;
+	if (lockstep && initial_players == 0) {
+		lockstep_enable(arena.game_state, seed, tick_usec);
+	}
+	sem_unlock(arena.sem_id, SEM_BOARD);
+
+	if ((lockstep || arbiter) && initial_players > 0) {
+		printf("Error: %s mode needs a fresh arena (%d players already joined)\n",
+			   lockstep ? "Lockstep" : "Arbiter", initial_players);
+		cleanup_ipc(&arena);
+		return 1;
+	}
+
+	signal(SIGINT, forward_signal);
+	signal(SIGTERM, forward_signal);
+	signal(SIGQUIT, forward_signal);
+
+	if (arbiter) {
+		g_arbiter = spawn_service(&arena, arbiter_loop);
+		if (g_arbiter == -1) {
+			cleanup_ipc(&arena);
+			return 1;
+		}
+		sem_lock(arena.sem_id, SEM_BOARD);
+		arena.game_state->arbiter_pid = g_arbiter;
+		arena.game_state->arbiter_alive_until = SERVICE_DEADLINE(tick_usec);
+		sem_unlock(arena.sem_id, SEM_BOARD);
+	}
+	// A referee can also serve players that joined with plain lemipc
+	if (referee) {
+		sem_lock(arena.sem_id, SEM_BOARD);
+		int running = referee_running(arena.game_state);
+		int referee_pid = arena.game_state->referee_pid;
+		sem_unlock(arena.sem_id, SEM_BOARD);
+		if (running) {
+			printf("Error: Arena already has a referee (pid %d)\n", referee_pid);
+			cleanup_ipc(&arena);
+			return 1;
+		}
+		g_referee = spawn_service(&arena, referee_loop);
+		if (g_referee == -1) {
+			cleanup_ipc(&arena);
+			return 1;
+		}
+		sem_lock(arena.sem_id, SEM_BOARD);
+		arena.game_state->referee_pid = g_referee;
+		arena.game_state->referee_alive_until = SERVICE_DEADLINE(tick_usec);
+		sem_unlock(arena.sem_id, SEM_BOARD);
+	}
+	// Place lockstep players up front, in slot order, so a seed replays the game
+	srand(seed);
+
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1) {
+		cpus = 1;
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	int expected = 0;
+	int fleet_size = 0;
+	int team, k;
+	for (team = 1; team <= teams; team++) {
+		if (team_threads) {
+			int cpu = pin ? (int)(g_spawned % cpus) : -1;
+			pid_t pid = spawn_team(&arena, team, per_team, cpu);
+			if (pid == -1) {
+				break;
+			}
+			g_pids[g_spawned++] = pid;
+			expected += per_team;
+			continue;
+		}
+		for (k = 0; k < per_team; k++) {
+			// Slots are partitioned per team so swarm players never collide
+			player_t player = arena;
+			player.team = team;
+			player.player_id = (team - 1) * MAX_PLAYERS_PER_TEAM + k;
+			if (lockstep) {
+				if (place_player(&player) == -1) {
+					continue;
+				}
+				lockstep_join(&player);
+				g_fleet[fleet_size++] = player;
+				continue;
+			}
+			int cpu = pin ? (int)(g_spawned % cpus) : -1;
+			pid_t pid = spawn_player(&player, cpu);
+			if (pid == -1) {
+				break;
+			}
+			g_pids[g_spawned++] = pid;
+			expected++;
+		}
+	}
+
+	// The whole lockstep fleet has joined before any player runs, so the
+	// first tick already waits for everyone and a seed replays the game
+	for (i = 0; i < fleet_size; i++) {
+		int cpu = pin ? (int)(g_spawned % cpus) : -1;
+		pid_t pid = spawn_player(&g_fleet[i], cpu);
+		if (pid == -1) {
+			for (; i < fleet_size; i++) {
+				lockstep_leave(&g_fleet[i]);
+			}
+			break;
+		}
+		g_pids[g_spawned++] = pid;
+		expected++;
+	}
+	double fork_ms = elapsed_ms(&start);
+
+	int joined = wait_for_players(&arena, initial_joins + expected,
+								  g_pids, g_spawned, 30000);
+	double fill_ms = elapsed_ms(&start);
+
+	printf("Spawned %d players across %d teams in %.3f ms (%d processes)\n",
+		   expected, teams, fork_ms, g_spawned);
+	if (joined == -1) {
+		printf("Arena did not fill within 30s\n");
+	} else {
+		joined -= initial_joins;
+		printf("Arena full after %.3f ms: %d players joined (%.0f joins/s)\n",
+			   fill_ms, joined, fill_ms > 0 ? joined * 1000.0 / fill_ms : 0.0);
+	}
+
+	for (i = 0; i < g_spawned; i++) {
+		if (g_pids[i] > 0) {
+			while (waitpid(g_pids[i], NULL, 0) == -1 && errno == EINTR) {
+			}
+			g_pids[i] = 0;
+		}
+	}
+	if (g_arbiter > 0) {
+		while (waitpid(g_arbiter, NULL, 0) == -1 && errno == EINTR) {
+		}
+		g_arbiter = 0;
+	}
+	if (g_referee > 0) {
+		while (waitpid(g_referee, NULL, 0) == -1 && errno == EINTR) {
+		}
+		g_referee = 0;
+	}
+
+	// Every player leaves the board on its way out, so the last one has
+	// already removed the arena unless some are still playing
+	cleanup_ipc(&arena);
+	return 0;
+}
@@ -0,0 +1,170 @@
+#include "game.h"
+
+// One process hosts a whole team as threads. Teammates share a cached copy of
+// the board and a common target, so the team scans the arena once per tick
+// instead of once per player and coordinates without the message queue. The
+// arena itself is still only changed through place_player/move_player and
+// remove_player.
+
+typedef struct {
+	pthread_mutex_t lock;
+	game_state_t view;        // only the board is kept up to date
+	struct timespec refreshed;
+	position_t target;
+	int target_team;
+} team_cache_t;
+
+typedef struct {
+	player_t player;
+	team_cache_t *cache;
+	unsigned int seed;
+	int display_mode;
+	int on_board;
+	int started;
+	pthread_t thread;
+} hosted_player_t;
+
+static volatile sig_atomic_t g_host_signal = 0;
+
+// Runs on the hosting thread only (see team_host_run), and only asks the
+// player threads to stop; they are removed once they have all returned
+static void host_signal_handler(int sig) {
+	g_host_signal = sig;
+	request_player_stop();
+}
+
+// Caller must hold cache->lock
+static void refresh_view(team_cache_t *cache, const player_t *player) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	long age_usec = (now.tv_sec - cache->refreshed.tv_sec) * 1000000L +
+					(now.tv_nsec - cache->refreshed.tv_nsec) / 1000;
+	if (cache->refreshed.tv_sec != 0 && age_usec < player->tick_usec) {
+		return;
+	}
+
+	sem_lock(player->sem_id, SEM_BOARD);
+	memcpy(cache->view.board, player->game_state->board, sizeof(cache->view.board));
+	sem_unlock(player->sem_id, SEM_BOARD);
+	cache->refreshed = now;
+}
+
+static position_t plan_from_cache(player_t *player, void *context) {
+	hosted_player_t *hosted = context;
+	team_cache_t *cache = hosted->cache;
+	position_t next;
+
+	pthread_mutex_lock(&cache->lock);
+	refresh_view(cache, player);
+
+	int searched = 0;
+	if (player->ai_budget_usec > 0) {
+		// Search from the team's view rather than a fresh copy of the arena
+		pthread_mutex_unlock(&cache->lock);
+		searched = lookahead_move_from(player, &cache->view, &cache->lock, &next);
+		pthread_mutex_lock(&cache->lock);
+	}
+	if (!searched) {
+		player_t local = *player;
+		local.game_state = &cache->view;
+		next = plan_shared_move(&local, &cache->target, &cache->target_team, &hosted->seed);
+	}
+
+	// Let teammates see the move right away; if move_player rejects it the
+	// next refresh puts things back
+	if (next.x != -1) {
+		BOARD_CELL(&cache->view, player->pos.x, player->pos.y) = EMPTY_CELL;
+		BOARD_CELL(&cache->view, next.x, next.y) = player->team;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return next;
+}
+
+static void *hosted_player_thread(void *arg) {
+	hosted_player_t *hosted = arg;
+
+	if (run_player_loop(&hosted->player, hosted->display_mode, plan_from_cache, hosted)) {
+		hosted->on_board = 0;
+	}
+	return NULL;
+}
+
+// Host `count` players of arena->team as threads of this process. Blocks until
+// every hosted player has died, the game is over or a signal arrived; players
+// still on the board are removed before returning. Returns the number of
+// players that could be placed, or -1 on failure.
+int team_host_run(player_t *arena, int count, int display_mode) {
+	team_cache_t *cache = calloc(1, sizeof(team_cache_t));
+	hosted_player_t *hosted = calloc(count, sizeof(hosted_player_t));
+	int placed = 0;
+	int i;
+
+	if (cache == NULL || hosted == NULL) {
+		perror("calloc");
+		free(cache);
+		free(hosted);
+		return -1;
+	}
+	pthread_mutex_init(&cache->lock, NULL);
+
+	signal(SIGINT, host_signal_handler);
+	signal(SIGTERM, host_signal_handler);
+	signal(SIGQUIT, host_signal_handler);
+
+	for (i = 0; i < count; i++) {
+		hosted_player_t *slot = &hosted[placed];
+		slot->player = *arena;
+		slot->player.player_id = (arena->team - 1) * MAX_PLAYERS_PER_TEAM + i;
+		if (place_player(&slot->player) == -1) {
+			continue;
+		}
+		slot->cache = cache;
+		slot->seed = time(NULL) + getpid() + i;
+		slot->display_mode = display_mode && placed == 0;
+		slot->on_board = 1;
+		placed++;
+	}
+
+	// Player threads inherit the signals blocked, so only this thread runs
+	// the handler while the players keep using the arena
+	sigset_t held, saved;
+	sigemptyset(&held);
+	sigaddset(&held, SIGINT);
+	sigaddset(&held, SIGTERM);
+	sigaddset(&held, SIGQUIT);
+	pthread_sigmask(SIG_BLOCK, &held, &saved);
+	for (i = 0; i < placed; i++) {
+		if (pthread_create(&hosted[i].thread, NULL, hosted_player_thread, &hosted[i]) != 0) {
+			perror("pthread_create");
+			remove_player(&hosted[i].player);
+			hosted[i].on_board = 0;
+		} else {
+			hosted[i].started = 1;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+	for (i = 0; i < placed; i++) {
+		if (hosted[i].started) {
+			pthread_join(hosted[i].thread, NULL);
+		}
+	}
+
+	if (g_host_signal) {
+		printf("\nReceived signal %d, cleaning up...\n", (int)g_host_signal);
+	}
+	// Nobody uses the arena from here on, the caller runs cleanup_ipc next
+	for (i = 0; i < placed; i++) {
+		if (hosted[i].on_board) {
+			hosted[i].on_board = 0;
+			remove_player(&hosted[i].player);
+		}
+	}
+
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+	free(hosted);
+	return placed;
+}